@@ -0,0 +1,274 @@
+'use strict';
+
+// Measures the cost of each call into the native binding: argument
+// validation, handle conversion, copying results into JS and freeing them.
+// The stub libconfsec does no work of its own, so the numbers are dominated by
+// the binding layer.
+//
+// Usage: node --expose-gc bench/binding.js [--iterations=N] [--sizes=a,b,c]
+//        [--json]
+
+const {
+  collectGarbage,
+  createClientHandle,
+  loadBinding,
+  nowNs,
+  parseOptions,
+  report,
+  round,
+  stubRequest,
+} = require('./common');
+
+const options = parseOptions({
+  iterations: 20000,
+  sizes: [64, 1024, 16384, 262144],
+  // Bytes processed per benchmark, used to cap iterations for large payloads
+  maxBytes: 256 * 1024 * 1024,
+});
+const binding = loadBinding();
+const client = createClientHandle(binding);
+const nodeTags = ['model=llama3.2:1b', 'region=us', 'tier=gpu', 'env=prod'];
+
+function iterationsFor(size) {
+  const capped = Math.floor(options.maxBytes / Math.max(size, 1));
+  return Math.max(100, Math.min(options.iterations, capped));
+}
+
+function repeat(n, fn) {
+  const values = [];
+  for (let i = 0; i < n; i++) {
+    values.push(fn(i));
+  }
+  return values;
+}
+
+function doRequest(stubOptions, body) {
+  return binding.confsecClientDoRequest(client, stubRequest(stubOptions, body));
+}
+
+function streamingResponse(chunks, chunkBytes) {
+  return doRequest({ stream: 1, sse: 0, chunks, 'chunk-bytes': chunkBytes });
+}
+
+function destroyResponses(responses) {
+  responses.forEach(response => binding.confsecResponseDestroy(response));
+}
+
+function copied(result) {
+  if (Buffer.isBuffer(result)) {
+    return result.length;
+  }
+  if (typeof result === 'string') {
+    return Buffer.byteLength(result);
+  }
+  if (Array.isArray(result)) {
+    return result.reduce((sum, value) => sum + copied(value), 0);
+  }
+  return 0;
+}
+
+// Each case sets up state for n calls, makes the call being measured and
+// returns the result, and tears the state down again. Only calls are timed.
+const cases = [
+  {
+    name: 'confsecClientCreate+Destroy',
+    setup: () => null,
+    call: () => binding.confsecClientDestroy(createClientHandle(binding)),
+  },
+  {
+    name: 'confsecClientGetDefaultCreditAmountPerRequest',
+    setup: () => null,
+    call: () => binding.confsecClientGetDefaultCreditAmountPerRequest(client),
+  },
+  {
+    name: 'confsecClientGetMaxCandidateNodes',
+    setup: () => null,
+    call: () => binding.confsecClientGetMaxCandidateNodes(client),
+  },
+  {
+    name: 'confsecClientSetDefaultNodeTags',
+    setup: () => null,
+    call: () => binding.confsecClientSetDefaultNodeTags(client, nodeTags),
+    teardown: () => binding.confsecClientSetDefaultNodeTags(client, []),
+  },
+  {
+    name: 'confsecClientGetDefaultNodeTags',
+    setup: () => binding.confsecClientSetDefaultNodeTags(client, nodeTags),
+    call: () => binding.confsecClientGetDefaultNodeTags(client),
+    teardown: () => binding.confsecClientSetDefaultNodeTags(client, []),
+  },
+  {
+    name: 'confsecClientGetWalletStatus',
+    setup: () => null,
+    call: () => binding.confsecClientGetWalletStatus(client),
+  },
+  {
+    name: 'confsecGetStats',
+    setup: () => null,
+    call: () => binding.confsecGetStats(),
+  },
+  {
+    name: 'confsecClientDoRequest(buffer)',
+    sized: true,
+    setup: (n, size) => ({
+      request: stubRequest({}, 'x'.repeat(size)),
+      responses: [],
+    }),
+    call: state => {
+      const response = binding.confsecClientDoRequest(client, state.request);
+      state.responses.push(response);
+    },
+    teardown: state => destroyResponses(state.responses),
+  },
+  {
+    name: 'confsecClientDoRequest(string)',
+    sized: true,
+    setup: (n, size) => ({
+      request: stubRequest({}, 'x'.repeat(size)).toString(),
+      responses: [],
+    }),
+    call: state => {
+      const response = binding.confsecClientDoRequest(client, state.request);
+      state.responses.push(response);
+    },
+    teardown: state => destroyResponses(state.responses),
+  },
+  {
+    name: 'confsecClientDoRequestAsync(buffer)',
+    sized: true,
+    async: true,
+    setup: (n, size) => ({
+      request: stubRequest({}, 'x'.repeat(size)),
+      responses: [],
+    }),
+    call: async state => {
+      const response = await binding.confsecClientDoRequestAsync(
+        client,
+        state.request
+      );
+      state.responses.push(response);
+    },
+    teardown: state => destroyResponses(state.responses),
+  },
+  {
+    name: 'confsecResponseGetMetadata',
+    setup: () => doRequest(),
+    call: response => binding.confsecResponseGetMetadata(response),
+    teardown: response => binding.confsecResponseDestroy(response),
+  },
+  {
+    name: 'confsecResponseIsStreaming',
+    setup: () => doRequest(),
+    call: response => binding.confsecResponseIsStreaming(response),
+    teardown: response => binding.confsecResponseDestroy(response),
+  },
+  {
+    name: 'confsecResponseGetBody',
+    sized: true,
+    setup: (n, size) => doRequest({ 'body-bytes': size }),
+    call: response => binding.confsecResponseGetBody(response),
+    teardown: response => binding.confsecResponseDestroy(response),
+  },
+  {
+    name: 'confsecResponseGetStream',
+    setup: () => ({ response: streamingResponse(0, 0), streams: [] }),
+    call: state => {
+      state.streams.push(binding.confsecResponseGetStream(state.response));
+    },
+    teardown: state => {
+      state.streams.forEach(stream =>
+        binding.confsecResponseStreamDestroy(stream)
+      );
+      binding.confsecResponseDestroy(state.response);
+    },
+  },
+  {
+    name: 'confsecResponseStreamGetNext',
+    sized: true,
+    setup: (n, size) => {
+      const response = streamingResponse(n, size);
+      return { response, stream: binding.confsecResponseGetStream(response) };
+    },
+    call: state => binding.confsecResponseStreamGetNext(state.stream),
+    teardown: state => {
+      binding.confsecResponseStreamDestroy(state.stream);
+      binding.confsecResponseDestroy(state.response);
+    },
+  },
+  {
+    name: 'confsecResponseStreamDestroy',
+    setup: n => {
+      const response = streamingResponse(0, 0);
+      const streams = repeat(n, () =>
+        binding.confsecResponseGetStream(response)
+      );
+      return { response, streams };
+    },
+    call: (state, i) => binding.confsecResponseStreamDestroy(state.streams[i]),
+    teardown: state => binding.confsecResponseDestroy(state.response),
+  },
+  {
+    name: 'confsecResponseDestroy',
+    setup: n => repeat(n, () => doRequest()),
+    call: (responses, i) => binding.confsecResponseDestroy(responses[i]),
+  },
+];
+
+async function run(benchmark, size) {
+  const n = iterationsFor(size);
+  const warmup = Math.min(1000, Math.ceil(n / 10));
+
+  // Warm up the JIT and inline caches with a separate state
+  const warmupState = benchmark.setup(warmup, size);
+  for (let i = 0; i < warmup; i++) {
+    await benchmark.call(warmupState, i);
+  }
+  if (benchmark.teardown) benchmark.teardown(warmupState);
+
+  const state = benchmark.setup(n, size);
+  collectGarbage();
+  binding.confsecStubResetStats();
+
+  let bytesCopied = 0;
+  const start = nowNs();
+  if (benchmark.async) {
+    for (let i = 0; i < n; i++) {
+      bytesCopied += copied(await benchmark.call(state, i));
+    }
+  } else {
+    for (let i = 0; i < n; i++) {
+      bytesCopied += copied(benchmark.call(state, i));
+    }
+  }
+  const elapsed = Number(nowNs() - start);
+
+  const stats = binding.confsecStubGetStats();
+  if (benchmark.teardown) benchmark.teardown(state);
+
+  return {
+    benchmark: benchmark.name,
+    size: benchmark.sized ? size : null,
+    iterations: n,
+    'ns/op': round(elapsed / n, 1),
+    'native allocs/op': round(stats.allocations / n),
+    'native bytes/op': round(stats.bytesAllocated / n, 1),
+    'copied bytes/op': round(bytesCopied / n, 1),
+  };
+}
+
+async function main() {
+  const results = [];
+  for (const benchmark of cases) {
+    const sizes = benchmark.sized ? options.sizes : [0];
+    for (const size of sizes) {
+      results.push(await run(benchmark, size));
+    }
+  }
+  binding.confsecClientDestroy(client);
+  report('binding', options, results);
+}
+
+main().catch(e => {
+  console.error(e);
+  process.exit(1);
+});
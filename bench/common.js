@@ -0,0 +1,193 @@
+'use strict';
+
+// Helpers shared by the benchmarks. Benchmarks run the real native binding
+// against the stub libconfsec, so the binding must have been built with
+// `npm run build:native:stub`.
+
+const path = require('path');
+const { parseArgs } = require('util');
+
+const BASE_URL = 'https://confsec.invalid';
+
+/**
+ * Load the native binding, checking that it was built against the stub
+ */
+function loadBinding() {
+  const bindingPath =
+    process.env.CONFSEC_BINDING ||
+    path.join(__dirname, '..', 'build', 'Release', 'confsec.node');
+  const binding = require(bindingPath);
+  if (typeof binding.confsecStubGetStats !== 'function') {
+    throw new Error(
+      `${bindingPath} was not built against the stub libconfsec, run ` +
+        '`npm run build:native:stub` first'
+    );
+  }
+  return binding;
+}
+
+/**
+ * Load the built SDK. The native binding is passed to clients explicitly, so
+ * the SDK's own lookup of confsec.node is bypassed.
+ */
+function loadSdk() {
+  const sdkPath =
+    process.env.CONFSEC_SDK || path.join(__dirname, '..', 'dist', 'index.js');
+  try {
+    return require(sdkPath);
+  } catch (e) {
+    throw new Error(`Failed to load ${sdkPath}, run \`npm run build\` first`, {
+      cause: e,
+    });
+  }
+}
+
+/**
+ * Parse command line options. Every default's type determines how the option
+ * is parsed; `--json` is always accepted.
+ */
+function parseOptions(defaults) {
+  const config = { json: { type: 'boolean', default: false } };
+  Object.keys(defaults).forEach(name => {
+    config[name] = { type: 'string' };
+  });
+  const { values } = parseArgs({ options: config });
+
+  const options = { json: values.json };
+  Object.entries(defaults).forEach(([name, value]) => {
+    const raw = values[name];
+    if (raw === undefined) {
+      options[name] = value;
+    } else if (Array.isArray(value)) {
+      options[name] = raw.split(',').map(Number);
+    } else if (typeof value === 'number') {
+      options[name] = Number(raw);
+    } else {
+      options[name] = raw;
+    }
+  });
+  return options;
+}
+
+/**
+ * Encode a raw HTTP request configuring the stub with x-confsec-stub-*
+ * headers
+ */
+function stubRequest(stubOptions = {}, body = '') {
+  const lines = [
+    'POST /v1/chat/completions HTTP/1.1',
+    'host: confsec.invalid',
+    'content-type: application/json',
+  ];
+  Object.entries(stubOptions).forEach(([name, value]) => {
+    lines.push(`x-confsec-stub-${name}: ${value}`);
+  });
+  const bodyBuffer = Buffer.from(body);
+  lines.push(`content-length: ${bodyBuffer.length}`);
+  const head = Buffer.from(lines.join('\r\n') + '\r\n\r\n');
+  return Buffer.concat([head, bodyBuffer]);
+}
+
+/**
+ * Headers configuring the stub for a fetch request
+ */
+function stubHeaders(stubOptions = {}) {
+  const headers = { 'content-type': 'application/json' };
+  Object.entries(stubOptions).forEach(([name, value]) => {
+    headers[`x-confsec-stub-${name}`] = String(value);
+  });
+  return headers;
+}
+
+/**
+ * Create a client handle directly through the binding
+ */
+function createClientHandle(binding, concurrentRequestsTarget = 10) {
+  return binding.confsecClientCreate(
+    BASE_URL,
+    'bench',
+    0,
+    '',
+    '',
+    '',
+    '',
+    concurrentRequestsTarget,
+    5,
+    [],
+    'prod'
+  );
+}
+
+function collectGarbage() {
+  if (typeof global.gc === 'function') {
+    global.gc();
+  }
+}
+
+function nowNs() {
+  return process.hrtime.bigint();
+}
+
+/**
+ * Get the given percentile (0-100) of a list of numbers
+ */
+function percentile(values, p) {
+  if (values.length === 0) {
+    return 0;
+  }
+  const sorted = Float64Array.from(values).sort();
+  const index = Math.ceil((p / 100) * sorted.length) - 1;
+  return sorted[Math.min(Math.max(index, 0), sorted.length - 1)];
+}
+
+function mean(values) {
+  if (values.length === 0) {
+    return 0;
+  }
+  return values.reduce((sum, value) => sum + value, 0) / values.length;
+}
+
+function stddev(values) {
+  const average = mean(values);
+  return Math.sqrt(mean(values.map(value => (value - average) ** 2)));
+}
+
+function round(value, digits = 2) {
+  const scale = 10 ** digits;
+  return Math.round(value * scale) / scale;
+}
+
+/**
+ * Print results as a table, or as JSON with --json
+ */
+function report(name, options, results) {
+  if (options.json) {
+    const output = {
+      benchmark: name,
+      node: process.version,
+      platform: `${process.platform}-${process.arch}`,
+      timestamp: new Date().toISOString(),
+      options,
+      results,
+    };
+    process.stdout.write(JSON.stringify(output, null, 2) + '\n');
+  } else {
+    console.table(results);
+  }
+}
+
+module.exports = {
+  collectGarbage,
+  createClientHandle,
+  loadBinding,
+  loadSdk,
+  mean,
+  nowNs,
+  parseOptions,
+  percentile,
+  report,
+  round,
+  stddev,
+  stubHeaders,
+  stubRequest,
+};
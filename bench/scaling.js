@@ -0,0 +1,128 @@
+'use strict';
+
+// Measures how confsecFetch throughput and latency scale with the number of
+// concurrent requests, against a stub backend with a fixed latency. Each
+// concurrent worker sends requests back to back. Event loop delay is sampled
+// alongside, since synchronous native calls block the event loop and
+// serialize requests that should overlap: when that happens, throughput
+// stops growing with concurrency and efficiency (throughput relative to
+// perfectly overlapped requests) falls.
+//
+// Usage: node bench/scaling.js [--concurrency=1,10,100,1000]
+//        [--targets=1,10,100] [--latencyMs=N] [--creditLatencyMs=N]
+//        [--rounds=N] [--json]
+
+const { monitorEventLoopDelay, performance } = require('perf_hooks');
+const {
+  collectGarbage,
+  loadBinding,
+  loadSdk,
+  parseOptions,
+  percentile,
+  report,
+  round,
+  stubHeaders,
+} = require('./common');
+
+const options = parseOptions({
+  concurrency: [1, 10, 100, 1000],
+  // concurrentRequestsTarget values to sweep
+  targets: [10, 100],
+  latencyMs: 50,
+  // Extra latency for requests beyond concurrentRequestsTarget
+  creditLatencyMs: 0,
+  // Requests sent by each concurrent worker
+  rounds: 5,
+});
+const binding = loadBinding();
+const sdk = loadSdk();
+
+const headers = stubHeaders({
+  'latency-ms': options.latencyMs,
+  'credit-latency-ms': options.creditLatencyMs,
+});
+const body = JSON.stringify({
+  model: 'stub',
+  messages: [{ role: 'user', content: 'Hello' }],
+});
+
+function tick() {
+  return new Promise(resolve => setTimeout(resolve, 20));
+}
+
+async function run(concurrency, concurrentRequestsTarget) {
+  const client = new sdk.ConfsecClient({
+    apiUrl: 'https://confsec.invalid',
+    apiKey: 'bench',
+    concurrentRequestsTarget,
+    libconfsec: binding,
+  });
+  const confsecFetch = client.getConfsecFetch();
+  const latencies = [];
+  let errors = 0;
+
+  const worker = async () => {
+    for (let i = 0; i < options.rounds; i++) {
+      const start = performance.now();
+      try {
+        const response = await confsecFetch(
+          'https://confsec.invalid/v1/chat/completions',
+          { method: 'POST', headers, body }
+        );
+        await response.arrayBuffer();
+        latencies.push(performance.now() - start);
+      } catch (e) {
+        errors++;
+      }
+    }
+  };
+
+  collectGarbage();
+  const loopDelay = monitorEventLoopDelay({ resolution: 10 });
+  loopDelay.enable();
+  // The first sample only starts the clock
+  await tick();
+  const start = performance.now();
+  await Promise.all(Array.from({ length: concurrency }, worker));
+  const elapsedMs = performance.now() - start;
+  // Let the sampling timer fire, in case the event loop has been blocked for
+  // the whole run
+  await tick();
+  loopDelay.disable();
+  client.close();
+
+  const requests = latencies.length;
+  const throughput = requests / (elapsedMs / 1000);
+  const idealThroughput = (concurrency * 1000) / options.latencyMs;
+  return {
+    concurrency,
+    concurrentRequestsTarget,
+    requests,
+    errors,
+    'req/s': round(throughput, 1),
+    efficiency: round(throughput / idealThroughput, 3),
+    'p50 ms': round(percentile(latencies, 50)),
+    'p99 ms': round(percentile(latencies, 99)),
+    'loop delay p50 ms': round(loopDelay.percentile(50) / 1e6),
+    'loop delay p99 ms': round(loopDelay.percentile(99) / 1e6),
+    'loop delay max ms': round(loopDelay.max / 1e6),
+  };
+}
+
+async function main() {
+  // Warm up
+  await run(1, options.targets[0]);
+
+  const results = [];
+  for (const target of options.targets) {
+    for (const concurrency of options.concurrency) {
+      results.push(await run(concurrency, target));
+    }
+  }
+  report('scaling', options, results);
+}
+
+main().catch(e => {
+  console.error(e);
+  process.exit(1);
+});
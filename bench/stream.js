@@ -0,0 +1,194 @@
+'use strict';
+
+// Measures streamed responses through each layer of the SDK, from the raw
+// binding up to the OpenAI SDK's SSE parsing, with simulated token streams:
+//
+//   binding   confsecResponseStreamGetNext() on the native binding
+//   stream    ConfsecResponseStream iteration
+//   readable  the fetch Response body returned by getConfsecFetch()
+//   openai    chat completion events from the OpenAI wrapper
+//
+// Reports throughput, CPU time per chunk, time to first chunk and the jitter
+// of the gaps between chunks as seen by the consumer.
+//
+// Usage: node bench/stream.js [--layers=binding,stream,readable,openai]
+//        [--concurrency=1,8,64] [--chunks=N] [--chunkBytes=N]
+//        [--intervalUs=N] [--json]
+
+const { performance } = require('perf_hooks');
+const {
+  collectGarbage,
+  loadBinding,
+  loadSdk,
+  mean,
+  parseOptions,
+  percentile,
+  report,
+  round,
+  stddev,
+  stubHeaders,
+  stubRequest,
+} = require('./common');
+
+const options = parseOptions({
+  layers: 'binding,stream,readable,openai',
+  concurrency: [1, 8, 64],
+  chunks: 256,
+  chunkBytes: 200,
+  // Time the stub takes to produce each chunk, i.e. the token rate
+  intervalUs: 0,
+});
+const binding = loadBinding();
+const sdk = loadSdk();
+
+const stubOptions = {
+  stream: 1,
+  chunks: options.chunks,
+  'chunk-bytes': options.chunkBytes,
+  'chunk-interval-us': options.intervalUs,
+};
+const completionUrl = 'https://confsec.invalid/v1/chat/completions';
+const completionBody = JSON.stringify({
+  model: 'stub',
+  messages: [{ role: 'user', content: 'Hello' }],
+  stream: true,
+});
+
+// Consumers stream one response each, calling onChunk with the size of every
+// chunk they receive
+const layers = {
+  async binding(onChunk, client) {
+    const request = stubRequest(stubOptions, completionBody);
+    const response = binding.confsecClientDoRequest(client.handle, request);
+    const stream = binding.confsecResponseGetStream(response);
+    try {
+      let chunk;
+      while ((chunk = binding.confsecResponseStreamGetNext(stream)) !== null) {
+        onChunk(chunk.length);
+        // Let concurrent consumers interleave
+        await null;
+      }
+    } finally {
+      binding.confsecResponseStreamDestroy(stream);
+      binding.confsecResponseDestroy(response);
+    }
+  },
+
+  async stream(onChunk, client) {
+    const request = stubRequest(stubOptions, completionBody);
+    const response = client.doRequest(request);
+    try {
+      for (const chunk of response.getStream()) {
+        onChunk(chunk.length);
+        await null;
+      }
+    } finally {
+      response.close();
+    }
+  },
+
+  async readable(onChunk, client) {
+    const response = await client.getConfsecFetch()(completionUrl, {
+      method: 'POST',
+      headers: stubHeaders(stubOptions),
+      body: completionBody,
+    });
+    for await (const chunk of response.body) {
+      onChunk(chunk.byteLength);
+    }
+  },
+
+  // Counts the bytes of content text rather than of the raw events
+  async openai(onChunk, client, openai) {
+    const stream = await openai.chat.completions.create(
+      {
+        model: 'stub',
+        messages: [{ role: 'user', content: 'Hello' }],
+        stream: true,
+      },
+      { headers: stubHeaders(stubOptions) }
+    );
+    for await (const event of stream) {
+      onChunk(event.choices[0]?.delta?.content?.length ?? 0);
+    }
+  },
+};
+
+async function run(layer, concurrency) {
+  const client = new sdk.ConfsecClient({
+    apiUrl: 'https://confsec.invalid',
+    apiKey: 'bench',
+    libconfsec: binding,
+  });
+  const openai = new sdk.OpenAI({
+    apiKey: 'bench',
+    confsecConfig: { apiUrl: 'https://confsec.invalid', libconfsec: binding },
+  });
+
+  const ttfc = [];
+  const gaps = [];
+  let chunks = 0;
+  let bytes = 0;
+
+  const consume = async () => {
+    const start = performance.now();
+    let last = null;
+    const onChunk = size => {
+      const now = performance.now();
+      if (last === null) {
+        ttfc.push(now - start);
+      } else {
+        gaps.push(now - last);
+      }
+      last = now;
+      chunks++;
+      bytes += size;
+    };
+    await layers[layer](onChunk, client, openai);
+  };
+
+  collectGarbage();
+  const cpuStart = process.cpuUsage();
+  const start = performance.now();
+  await Promise.all(Array.from({ length: concurrency }, consume));
+  const elapsedMs = performance.now() - start;
+  const cpu = process.cpuUsage(cpuStart);
+
+  client.close();
+  openai.close();
+
+  const seconds = elapsedMs / 1000;
+  return {
+    layer,
+    concurrency,
+    chunks,
+    'chunks/s': Math.round(chunks / seconds),
+    'MB/s': round(bytes / seconds / 1e6),
+    'cpu us/chunk': round((cpu.user + cpu.system) / chunks),
+    'ttfc p50 ms': round(percentile(ttfc, 50), 3),
+    'ttfc p99 ms': round(percentile(ttfc, 99), 3),
+    'gap mean ms': round(mean(gaps), 3),
+    'gap p99 ms': round(percentile(gaps, 99), 3),
+    'jitter ms': round(stddev(gaps), 3),
+  };
+}
+
+async function main() {
+  const results = [];
+  for (const layer of options.layers.split(',')) {
+    if (!layers[layer]) {
+      throw new Error(`Unknown layer: ${layer}`);
+    }
+    // Warm up
+    await run(layer, 1);
+    for (const concurrency of options.concurrency) {
+      results.push(await run(layer, concurrency));
+    }
+  }
+  report('stream', options, results);
+}
+
+main().catch(e => {
+  console.error(e);
+  process.exit(1);
+});
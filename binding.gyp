@@ -1,4 +1,7 @@
 {
+  "variables": {
+    "libconfsec_stub%": "<!(node -p \"process.env.LIBCONFSEC_STUB === 'true'\")"
+  },
   "targets": [
     {
       "target_name": "confsec",
@@ -7,15 +10,22 @@
       ],
       "include_dirs": [
         "<!@(node -p \"require('node-addon-api').include\")",
-        "native/src",
-        "native/lib"
-      ],
-      "libraries": [
-        "<(module_root_dir)/native/lib/libconfsec.a"
+        "native/src"
       ],
       "dependencies": [
         "<!(node -p \"require('node-addon-api').gyp\")"
       ],
+      "conditions": [
+        ["libconfsec_stub=='true'", {
+          "include_dirs": [ "native/stub" ],
+          "dependencies": [ "confsec_stub" ]
+        }, {
+          "include_dirs": [ "native/lib" ],
+          "libraries": [
+            "<(module_root_dir)/native/lib/libconfsec.a"
+          ]
+        }]
+      ],
       "cflags!": [ "-fno-exceptions" ],
       "cflags_cc!": [ "-fno-exceptions" ],
       "xcode_settings": {
@@ -28,5 +38,26 @@
       },
       "defines": [ "NAPI_DISABLE_CPP_EXCEPTIONS" ]
     }
+  ],
+  "conditions": [
+    ["libconfsec_stub=='true'", {
+      "targets": [
+        {
+          "target_name": "confsec_stub",
+          "product_name": "confsec",
+          "type": "static_library",
+          "sources": [
+            "native/stub/libconfsec_stub.cc"
+          ],
+          "include_dirs": [
+            "native/stub"
+          ],
+          "xcode_settings": {
+            "CLANG_CXX_LIBRARY": "libc++",
+            "MACOSX_DEPLOYMENT_TARGET": "10.7"
+          }
+        }
+      ]
+    }]
   ]
-}
\ No newline at end of file
+}
@@ -1,50 +1,855 @@
 #include <napi.h>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 #include "libconfsec.h"
+#include "probes.h"
 
 using namespace std;
 
+// Error classification. libconfsec only reports free-form messages, so errors
+// are classified by the phrases they contain and surfaced to JS through the
+// `code` and `transient` properties of the thrown error. Patterns are checked
+// in order, so more specific phrases must come first.
+struct ErrorClass {
+    const char* code;
+    bool transient;
+};
+
+struct ErrorPattern {
+    const char* phrase;
+    ErrorClass errorClass;
+};
+
+static const ErrorClass kUnknownError = {"CONFSEC_UNKNOWN", false};
+
+// Every code an error may be classified as
+static const char* const kErrorCodes[] = {
+    "CONFSEC_NO_NODES",
+    "CONFSEC_RATE_LIMITED",
+    "CONFSEC_UNAVAILABLE",
+    "CONFSEC_TIMEOUT",
+    "CONFSEC_NETWORK",
+    "CONFSEC_INSUFFICIENT_CREDITS",
+    "CONFSEC_AUTH",
+    "CONFSEC_POLICY",
+    "CONFSEC_INVALID_REQUEST",
+    "CONFSEC_UNKNOWN",
+};
+static const size_t kErrorCodeCount = sizeof(kErrorCodes) / sizeof(kErrorCodes[0]);
+
+static const ErrorPattern kErrorPatterns[] = {
+    {"no nodes", {"CONFSEC_NO_NODES", true}},
+    {"nodes available", {"CONFSEC_NO_NODES", true}},
+    {"no suitable node", {"CONFSEC_NO_NODES", true}},
+    {"no candidate node", {"CONFSEC_NO_NODES", true}},
+    {"rate limit", {"CONFSEC_RATE_LIMITED", true}},
+    {"too many requests", {"CONFSEC_RATE_LIMITED", true}},
+    {"insufficient credit", {"CONFSEC_INSUFFICIENT_CREDITS", false}},
+    {"not enough credit", {"CONFSEC_INSUFFICIENT_CREDITS", false}},
+    {"unauthorized", {"CONFSEC_AUTH", false}},
+    {"unauthenticated", {"CONFSEC_AUTH", false}},
+    {"forbidden", {"CONFSEC_AUTH", false}},
+    {"api key", {"CONFSEC_AUTH", false}},
+    {"policy", {"CONFSEC_POLICY", false}},
+    {"transparency", {"CONFSEC_POLICY", false}},
+    {"attestation", {"CONFSEC_POLICY", false}},
+    {"signature", {"CONFSEC_POLICY", false}},
+    {"verif", {"CONFSEC_POLICY", false}},
+    {"service unavailable", {"CONFSEC_UNAVAILABLE", true}},
+    {"bad gateway", {"CONFSEC_UNAVAILABLE", true}},
+    {"gateway timeout", {"CONFSEC_UNAVAILABLE", true}},
+    {"deadline exceeded", {"CONFSEC_TIMEOUT", true}},
+    {"timed out", {"CONFSEC_TIMEOUT", true}},
+    {"timeout", {"CONFSEC_TIMEOUT", true}},
+    {"connection reset", {"CONFSEC_NETWORK", true}},
+    {"connection refused", {"CONFSEC_NETWORK", true}},
+    {"broken pipe", {"CONFSEC_NETWORK", true}},
+    {"unexpected eof", {"CONFSEC_NETWORK", true}},
+    {"network is unreachable", {"CONFSEC_NETWORK", true}},
+    {"no such host", {"CONFSEC_NETWORK", true}},
+    {"dial tcp", {"CONFSEC_NETWORK", true}},
+    {"tls handshake", {"CONFSEC_NETWORK", true}},
+    {"invalid", {"CONFSEC_INVALID_REQUEST", false}},
+    {"malformed", {"CONFSEC_INVALID_REQUEST", false}},
+    {"failed to parse", {"CONFSEC_INVALID_REQUEST", false}},
+};
+
+ErrorClass ClassifyError(const string& message) {
+    string lower(message);
+    transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return tolower(c); });
+    for (const ErrorPattern& pattern : kErrorPatterns) {
+        if (lower.find(pattern.phrase) != string::npos) {
+            return pattern.errorClass;
+        }
+    }
+    return kUnknownError;
+}
+
+// Process-wide counters reported by confsecGetStats. They are updated with
+// relaxed atomics so the hot path never takes a lock; a snapshot is therefore
+// not a consistent cut across counters.
+struct Stats {
+    // Gauges. A synchronous request only counts towards inFlightRequests and
+    // nativeBytesOutstanding while it blocks its JS thread, so only other
+    // threads can see it; in practice these cover async requests.
+    atomic<int64_t> liveClients{0};
+    atomic<int64_t> inFlightRequests{0};
+    atomic<int64_t> liveResponses{0};
+    atomic<int64_t> openStreams{0};
+    // Request bytes held by the binding while libconfsec sends them
+    atomic<int64_t> nativeBytesOutstanding{0};
+    // Totals
+    atomic<int64_t> requests{0};
+    atomic<int64_t> chunks{0};
+    // Body and chunk bytes copied into JS
+    atomic<int64_t> bytesDelivered{0};
+    atomic<int64_t> errors[kErrorCodeCount] = {};
+};
+
+static Stats stats;
+
+inline void Add(atomic<int64_t>& counter, int64_t delta) {
+    counter.fetch_add(delta, memory_order_relaxed);
+}
+
+void CountError(const char* code) {
+    for (size_t i = 0; i < kErrorCodeCount; i++) {
+        if (strcmp(kErrorCodes[i], code) == 0) {
+            Add(stats.errors[i], 1);
+            return;
+        }
+    }
+}
+
+// Opt-in record of native work, read by confsecTraceStop. Spans are written
+// into a ring buffer without locking, from the JS thread and worker threads,
+// and the oldest are overwritten once it is full.
+struct TraceSpan {
+    // Index of the span plus 1, or 0 while it is being written
+    atomic<uint64_t> seq{0};
+    atomic<const char*> name{nullptr};
+    atomic<int64_t> startNs{0};
+    atomic<int64_t> endNs{0};
+    atomic<uint32_t> tid{0};
+    atomic<uint64_t> id{0};
+};
+
+struct TraceBuffer {
+    explicit TraceBuffer(size_t capacity) : capacity(capacity), spans(new TraceSpan[capacity]) {}
+
+    const size_t capacity;
+    unique_ptr<TraceSpan[]> spans;
+    atomic<uint64_t> next{0};
+};
+
+static atomic<bool> tracing{false};
+// Threads recording a span. A thread may still be writing to the buffer after
+// tracing stops, so a replaced buffer is only freed once this drops to zero.
+static atomic<int64_t> traceWriters{0};
+// Reused while the capacity stays the same, and only replaced while tracing is
+// stopped. Starting and stopping hold traceMutex.
+static atomic<TraceBuffer*> traceBuffer{nullptr};
+static mutex traceMutex;
+static atomic<uint32_t> nextTraceTid{1};
+// Ids of requests, shared by trace spans and probes
+static atomic<uint64_t> nextRequestId{1};
+
+int64_t NowNs() {
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Small sequential id of the calling thread
+uint32_t TraceTid() {
+    thread_local uint32_t tid = nextTraceTid.fetch_add(1, memory_order_relaxed);
+    return tid;
+}
+
+// Record a span of the calling thread if tracing is enabled. Spans with an id
+// are asynchronous: they may overlap other spans, and are grouped by id.
+void TraceRecord(const char* name, int64_t startNs, int64_t endNs, uint64_t id = 0) {
+    if (!tracing.load(memory_order_relaxed)) {
+        return;
+    }
+    // Seen by ConfsecTraceStart before it frees a buffer, unless tracing was
+    // already stopped when we check again
+    traceWriters.fetch_add(1);
+    if (tracing.load()) {
+        TraceBuffer* buffer = traceBuffer.load(memory_order_acquire);
+        uint64_t index = buffer->next.fetch_add(1, memory_order_relaxed);
+        TraceSpan& span = buffer->spans[index % buffer->capacity];
+        span.seq.store(0, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+        span.name.store(name, memory_order_relaxed);
+        span.startNs.store(startNs, memory_order_relaxed);
+        span.endNs.store(endNs, memory_order_relaxed);
+        span.tid.store(TraceTid(), memory_order_relaxed);
+        span.id.store(id, memory_order_relaxed);
+        span.seq.store(index + 1, memory_order_release);
+    }
+    traceWriters.fetch_sub(1, memory_order_release);
+}
+
+// Synchronous calls hold the JS thread for their whole duration, so each one
+// records its wall time, reported by confsecGetCallStats
+enum CallId {
+    kCallClientCreate,
+    kCallClientDestroy,
+    kCallClientGetDefaultCreditAmountPerRequest,
+    kCallClientGetMaxCandidateNodes,
+    kCallClientGetDefaultNodeTags,
+    kCallClientSetDefaultNodeTags,
+    kCallNodeTagSetCreate,
+    kCallClientGetWalletStatus,
+    kCallClientStartWalletRefresh,
+    kCallClientReadWallet,
+    kCallClientRefreshWallet,
+    kCallClientStopWalletRefresh,
+    kCallClientDoRequest,
+    kCallClientDoRequestAsync,
+    kCallResponseDestroy,
+    kCallResponseGetMetadata,
+    kCallResponseIsStreaming,
+    kCallResponseGetBody,
+    kCallResponseGetStream,
+    kCallResponseStreamGetNext,
+    kCallResponseStreamGetNextAsync,
+    kCallResponseStreamDestroy,
+    kCallCount,
+};
+
+static const char* const kCallNames[kCallCount] = {
+    "confsecClientCreate",
+    "confsecClientDestroy",
+    "confsecClientGetDefaultCreditAmountPerRequest",
+    "confsecClientGetMaxCandidateNodes",
+    "confsecClientGetDefaultNodeTags",
+    "confsecClientSetDefaultNodeTags",
+    "confsecNodeTagSetCreate",
+    "confsecClientGetWalletStatus",
+    "confsecClientStartWalletRefresh",
+    "confsecClientReadWallet",
+    "confsecClientRefreshWallet",
+    "confsecClientStopWalletRefresh",
+    "confsecClientDoRequest",
+    "confsecClientDoRequestAsync",
+    "confsecResponseDestroy",
+    "confsecResponseGetMetadata",
+    "confsecResponseIsStreaming",
+    "confsecResponseGetBody",
+    "confsecResponseGetStream",
+    "confsecResponseStreamGetNext",
+    "confsecResponseStreamGetNextAsync",
+    "confsecResponseStreamDestroy",
+};
+
+// Calls are bucketed by the power of two of their duration in microseconds:
+// bucket 0 counts calls under 1us and bucket i calls of [2^(i-1), 2^i) us
+static const int kCallBucketCount = 32;
+
+struct CallStats {
+    atomic<int64_t> calls{0};
+    atomic<int64_t> totalNs{0};
+    atomic<int64_t> maxNs{0};
+    atomic<int64_t> buckets[kCallBucketCount] = {};
+};
+
+static CallStats callStats[kCallCount];
+
+// Get the number following "key": in a JSON object, or NaN if missing
+double ParseJSONNumber(const char* json, const char* key) {
+    char needle[64];
+    int needleLength = snprintf(needle, sizeof(needle), "\"%s\":", key);
+    const char* found = strstr(json, needle);
+    return found == nullptr ? NAN : strtod(found + needleLength, nullptr);
+}
+
+// Refreshes the wallet status of a client on a background thread, right away,
+// then at a fixed interval and whenever nudged. The last status is kept behind
+// a mutex for confsecClientReadWallet, so that reading credits never calls
+// into libconfsec.
+class WalletRefresher {
+public:
+    // Credits available, held and spent
+    static const int kValueCount = 3;
+
+    WalletRefresher(uintptr_t handle, int64_t intervalMs)
+        : handle(handle), interval(intervalMs) {
+        thread = std::thread(&WalletRefresher::Run, this);
+    }
+
+    // Blocks until a refresh in flight has finished; stop and destroy
+    // refreshers with WalletRefreshStopWorker to do that off the JS thread
+    ~WalletRefresher() {
+        Stop();
+        thread.join();
+    }
+
+    // Copy the last status into values, or return false if no refresh has
+    // succeeded yet
+    bool Read(double* values) {
+        lock_guard<mutex> lock(statusMutex);
+        if (!hasStatus) {
+            return false;
+        }
+        copy(status, status + kValueCount, values);
+        return true;
+    }
+
+    // Refresh as soon as possible; nudges during a refresh are coalesced
+    void Nudge() {
+        {
+            lock_guard<mutex> lock(stateMutex);
+            pending = true;
+        }
+        wake.notify_one();
+    }
+
+    // Ask the thread to exit once a refresh in flight has finished
+    void Stop() {
+        {
+            lock_guard<mutex> lock(stateMutex);
+            stopping = true;
+        }
+        wake.notify_one();
+    }
+
+private:
+    void Run() {
+        Refresh();
+        unique_lock<mutex> lock(stateMutex);
+        while (!stopping) {
+            wake.wait_for(lock, interval, [this] { return stopping || pending; });
+            if (stopping) {
+                break;
+            }
+            pending = false;
+            lock.unlock();
+            Refresh();
+            lock.lock();
+        }
+    }
+
+    // Failed refreshes keep the previous status
+    void Refresh() {
+        char* err = nullptr;
+        char* json = Confsec_ClientGetWalletStatus(handle, &err);
+        if (err != nullptr) {
+            free(err);
+            return;
+        }
+        if (json == nullptr) {
+            return;
+        }
+        double available = ParseJSONNumber(json, "credits_available");
+        double held = ParseJSONNumber(json, "credits_held");
+        double spent = ParseJSONNumber(json, "credits_spent");
+        Confsec_Free(json);
+
+        lock_guard<mutex> lock(statusMutex);
+        status[0] = available;
+        status[1] = held;
+        status[2] = spent;
+        hasStatus = true;
+    }
+
+    uintptr_t handle;
+    chrono::milliseconds interval;
+    mutex statusMutex;
+    double status[kValueCount] = {};
+    bool hasStatus = false;
+    mutex stateMutex;
+    condition_variable wake;
+    bool pending = false;
+    bool stopping = false;
+    std::thread thread;
+};
+
+// Stops a wallet refresher and joins its thread on the libuv thread pool, so
+// that a refresh in flight doesn't hold up the JS thread, then settles a
+// promise once the client is no longer used by it
+class WalletRefreshStopWorker : public Napi::AsyncWorker {
+public:
+    WalletRefreshStopWorker(Napi::Env env, unique_ptr<WalletRefresher> refresher)
+        : Napi::AsyncWorker(env), deferred(Napi::Promise::Deferred::New(env)), refresher(std::move(refresher)) {
+        this->refresher->Stop();
+    }
+
+    Napi::Promise Promise() { return deferred.Promise(); }
+
+    void Execute() override { refresher.reset(); }
+
+    void OnOK() override { deferred.Resolve(Env().Undefined()); }
+
+private:
+    Napi::Promise::Deferred deferred;
+    unique_ptr<WalletRefresher> refresher;
+};
+
+// State of each environment the addon is loaded in
+struct AddonData {
+    // Called on the JS thread, after the call has returned, with every call
+    // taking at least slowCallThresholdNs
+    Napi::ThreadSafeFunction slowCallHook;
+    int64_t slowCallThresholdNs = 0;
+    // Keyed by client handle; threads are stopped when the environment exits
+    map<uintptr_t, unique_ptr<WalletRefresher>> walletRefreshers;
+};
+
+void RecordCall(Napi::Env env, CallId id, int64_t ns) {
+    CallStats& call = callStats[id];
+    Add(call.calls, 1);
+    Add(call.totalNs, ns);
+    int64_t max = call.maxNs.load(memory_order_relaxed);
+    while (ns > max && !call.maxNs.compare_exchange_weak(max, ns, memory_order_relaxed)) {
+    }
+    int bucket = 0;
+    for (int64_t us = ns / 1000; us > 0 && bucket < kCallBucketCount - 1; us >>= 1) {
+        bucket++;
+    }
+    Add(call.buckets[bucket], 1);
+
+    AddonData* data = env.GetInstanceData<AddonData>();
+    if (data != nullptr && data->slowCallThresholdNs > 0 && ns >= data->slowCallThresholdNs) {
+        data->slowCallHook.NonBlockingCall([id, ns](Napi::Env env, Napi::Function hook) {
+            hook.Call({Napi::String::New(env, kCallNames[id]), Napi::Number::New(env, ns / 1e6)});
+        });
+    }
+}
+
+// Records the wall time of the enclosing call when it returns
+class CallTimer {
+public:
+    CallTimer(Napi::Env env, CallId id) : env(env), id(id), startNs(NowNs()) {}
+
+    ~CallTimer() {
+        int64_t endNs = NowNs();
+        RecordCall(env, id, endNs - startNs);
+        TraceRecord(kCallNames[id], startNs, endNs);
+    }
+
+private:
+    Napi::Env env;
+    CallId id;
+    int64_t startNs;
+};
+
+#define TIME_CALL(id) CallTimer callTimer(info.Env(), id);
+
+// Opt-in record of the handles not yet destroyed, with the JS stack that
+// created them, for finding leaks. Tracking is enabled while at least one
+// caller of confsecTrackHandles has enabled it.
+struct LiveHandle {
+    int64_t createdNs;
+    string stack;
+};
+
+static atomic<int> handleTrackers{0};
+static mutex liveHandlesMutex;
+// Keyed by kind ("client", "response" or "stream") and handle
+static map<pair<string, uintptr_t>, LiveHandle> liveHandles;
+
+// Capture the current JS stack if handles are tracked, without its first line
+string CaptureStack(Napi::Env env) {
+    if (handleTrackers.load(memory_order_relaxed) == 0) {
+        return string();
+    }
+    Napi::Value stack = Napi::Error::New(env).Get("stack");
+    if (!stack.IsString()) {
+        return string();
+    }
+    string result = stack.As<Napi::String>().Utf8Value();
+    size_t firstFrame = result.find('\n');
+    return firstFrame == string::npos ? string() : result.substr(firstFrame + 1);
+}
+
+void TrackHandle(const char* kind, uintptr_t handle, string stack) {
+    if (handleTrackers.load(memory_order_relaxed) == 0) {
+        return;
+    }
+    lock_guard<mutex> lock(liveHandlesMutex);
+    liveHandles[make_pair(string(kind), handle)] = {NowNs(), std::move(stack)};
+}
+
+void UntrackHandle(const char* kind, uintptr_t handle) {
+    if (handleTrackers.load(memory_order_relaxed) == 0) {
+        return;
+    }
+    lock_guard<mutex> lock(liveHandlesMutex);
+    liveHandles.erase(make_pair(string(kind), handle));
+}
+
+// Create an error carrying the classification of its message
+Napi::Error ConfsecError(Napi::Env env, const string& message) {
+    ErrorClass errorClass = ClassifyError(message);
+    CountError(errorClass.code);
+    PROBE_ERROR(errorClass.code, message.c_str());
+    Napi::Error error = Napi::Error::New(env, message);
+    error.Set("code", Napi::String::New(env, errorClass.code));
+    error.Set("transient", Napi::Boolean::New(env, errorClass.transient));
+    return error;
+}
+
 // Helper macros for error handling
 #define INIT_ERROR char* err = nullptr;
-#define HANDLE_ERROR(env, err)                                           \
-    if (err != nullptr) {                                                \
-        Napi::Error::New(env, string(err)).ThrowAsJavaScriptException(); \
-        free(err);                                                       \
-        return env.Undefined();                                          \
-    }
-
-// Helper function to convert JavaScript array to C string array
-vector<char*> JSArrayToCStringArray(const Napi::Array& jsArray) {
-    vector<char*> result;
-    for (size_t i = 0; i < jsArray.Length(); i++) {
-        Napi::Value element = jsArray[i];
-        // Throws if not a string
-        string str = element.As<Napi::String>().Utf8Value();
-        char* cstr = new char[str.length() + 1];
-        strcpy(cstr, str.c_str());
-        result.push_back(cstr);
+#define HANDLE_ERROR(env, err)                                            \
+    if (err != nullptr) {                                                 \
+        ConfsecError(env, string(err)).ThrowAsJavaScriptException();      \
+        free(err);                                                        \
+        return env.Undefined();                                           \
     }
-    return result;
+
+// Argument marshalling. JS strings are decoded with napi_get_value_string_utf8
+// straight into NUL-terminated buffers that libconfsec can read: short ones
+// into an inline buffer on the stack, longer ones into scratch buffers that are
+// kept per thread and reused by later calls, so that calls don't allocate once
+// the buffers have grown to fit their arguments.
+
+// Scratch buffers larger than this are freed rather than kept for reuse
+static const size_t kMaxScratchBytes = 1 << 20;
+// Each thread keeps at most this many idle buffers of each type, and this many
+// bytes of them, so that the request copies given back after a burst of
+// concurrent requests don't keep the burst's memory for good
+static const size_t kMaxScratchBuffers = 8;
+static const size_t kMaxScratchPoolBytes = 2 << 20;
+
+template <typename Buffer>
+struct ScratchPool {
+    vector<Buffer> buffers;
+    size_t bytes = 0;
+};
+
+template <typename Buffer>
+ScratchPool<Buffer>& ThreadScratchPool() {
+    thread_local ScratchPool<Buffer> pool;
+    return pool;
 }
 
-// Helper function to free C string array
-void FreeCStringArray(vector<char*>& arr) {
-    for (char* str : arr) {
-        delete[] str;
+template <typename Buffer>
+size_t ScratchBytes(const Buffer& buffer) {
+    return buffer.capacity() * sizeof(typename Buffer::value_type);
+}
+
+// Take an empty buffer from the scratch pool of the calling thread
+template <typename Buffer>
+Buffer TakeScratch() {
+    ScratchPool<Buffer>& pool = ThreadScratchPool<Buffer>();
+    if (pool.buffers.empty()) {
+        return Buffer();
+    }
+    Buffer buffer = std::move(pool.buffers.back());
+    pool.buffers.pop_back();
+    pool.bytes -= ScratchBytes(buffer);
+    return buffer;
+}
+
+// Give a buffer back to the scratch pool of the calling thread, unless it
+// holds no more than a new one or the pool is full, in which case it is freed
+template <typename Buffer>
+void ReturnScratch(Buffer& buffer) {
+    ScratchPool<Buffer>& pool = ThreadScratchPool<Buffer>();
+    size_t bytes = ScratchBytes(buffer);
+    if (buffer.capacity() <= Buffer().capacity() || bytes > kMaxScratchBytes ||
+        pool.buffers.size() >= kMaxScratchBuffers || pool.bytes + bytes > kMaxScratchPoolBytes) {
+        Buffer().swap(buffer);
+        return;
+    }
+    buffer.clear();
+    pool.bytes += bytes;
+    pool.buffers.push_back(std::move(buffer));
+}
+
+// Scratch buffer returned to the pool when it goes out of scope
+template <typename Buffer>
+class Scratch {
+public:
+    Scratch() : buffer(TakeScratch<Buffer>()) {}
+    ~Scratch() { ReturnScratch(buffer); }
+    Scratch(const Scratch&) = delete;
+    Scratch& operator=(const Scratch&) = delete;
+
+    Buffer& operator*() { return buffer; }
+    Buffer* operator->() { return &buffer; }
+    const Buffer* operator->() const { return &buffer; }
+
+    // Keep the buffer beyond this scope. It can be given back to the pool
+    // with ReturnScratch once done with.
+    Buffer Release() { return std::move(buffer); }
+
+private:
+    Buffer buffer;
+};
+
+// NUL-terminated UTF-8 copy of a JS string
+class Utf8String {
+public:
+    static const size_t kInlineSize = 256;
+
+    Utf8String() { inlineData[0] = '\0'; }
+    Utf8String(napi_env env, napi_value value) { Decode(env, value); }
+    Utf8String(const Utf8String&) = delete;
+    Utf8String& operator=(const Utf8String&) = delete;
+
+    // Decode a value that is known to be a string
+    void Decode(napi_env env, napi_value value) {
+        napi_get_value_string_utf8(env, value, inlineData, kInlineSize, &length);
+        // Decoding stops before a character that doesn't fit, which is at most
+        // 4 bytes long, so a shorter result is the whole string
+        if (length + 4 < kInlineSize) {
+            data = inlineData;
+            return;
+        }
+        napi_get_value_string_utf8(env, value, nullptr, 0, &length);
+        scratch->resize(length);
+        napi_get_value_string_utf8(env, value, &(*scratch)[0], length + 1, &length);
+        data = &(*scratch)[0];
+    }
+
+    char* Data() { return data; }
+    size_t Length() const { return length; }
+
+    // Move the string into a buffer that can be kept beyond this scope
+    string Release() {
+        if (data != inlineData) {
+            return scratch.Release();
+        }
+        string result = TakeScratch<string>();
+        result.assign(inlineData, length);
+        return result;
+    }
+
+private:
+    char inlineData[kInlineSize];
+    Scratch<string> scratch;
+    char* data = inlineData;
+    size_t length = 0;
+};
+
+// NUL-terminated UTF-8 copies of the strings in a JS array, decoded back to
+// back into a scratch buffer, in the char** form libconfsec takes them
+class Utf8StringArray {
+public:
+    // Returns false with a JS exception pending if an element isn't a string
+    bool Decode(Napi::Env env, const Napi::Array& array) {
+        uint32_t count = array.Length();
+        for (uint32_t i = 0; i < count; i++) {
+            Napi::Value element = array[i];
+            if (!element.IsString()) {
+                Napi::TypeError::New(env, "Node tags must be strings").ThrowAsJavaScriptException();
+                return false;
+            }
+            size_t length = 0;
+            napi_get_value_string_utf8(env, element, nullptr, 0, &length);
+            size_t offset = bytes->size();
+            bytes->resize(offset + length + 1);
+            napi_get_value_string_utf8(env, element, &(*bytes)[offset], length + 1, &length);
+            // Offsets become pointers once the buffer has stopped growing
+            pointers->push_back(reinterpret_cast<char*>(offset));
+        }
+        for (char*& pointer : *pointers) {
+            pointer = &(*bytes)[0] + reinterpret_cast<size_t>(pointer);
+        }
+        return true;
+    }
+
+    char** Data() { return pointers->data(); }
+    size_t Size() const { return pointers->size(); }
+
+    // Separate the strings with commas rather than NULs, after which Data() no
+    // longer holds them apart
+    void Join() {
+        for (size_t i = 0; i + 1 < bytes->size(); i++) {
+            if ((*bytes)[i] == '\0') {
+                (*bytes)[i] = ',';
+            }
+        }
     }
-    arr.clear();
+    const char* Bytes() const { return bytes->data(); }
+    size_t JoinedLength() const { return bytes->empty() ? 0 : bytes->size() - 1; }
+
+private:
+    Scratch<string> bytes;
+    Scratch<vector<char*>> pointers;
+};
+
+// Node tags marshalled once, for use by any number of requests and clients
+struct NodeTagSet {
+    vector<string> tags;
+    // The tags in the form libconfsec takes them, pointing into tags
+    vector<char*> tagPointers;
+    // The tags as the value of an x-confsec-node-tags header
+    string header;
+};
+
+// Marks the externals holding node tag sets, so that other externals aren't
+// mistaken for them
+static const napi_type_tag kNodeTagSetTypeTag = {0x9a1c3e6f5b2d4871, 0xc4f0e2a86d1b7359};
+
+// Get the node tag set held by a value, or nullptr if it holds none
+NodeTagSet* GetNodeTagSet(const Napi::Value& value) {
+    if (!value.IsExternal()) {
+        return nullptr;
+    }
+    Napi::External<NodeTagSet> external = value.As<Napi::External<NodeTagSet>>();
+    return external.CheckTypeTag(&kNodeTagSetTypeTag) ? external.Data() : nullptr;
+}
+
+// Decode an array of node tags that fit in an x-confsec-node-tags header.
+// Returns false with a JS exception pending if they don't.
+bool ReadNodeTags(Napi::Env env, const Napi::Array& array, Utf8StringArray& tags) {
+    if (!tags.Decode(env, array)) {
+        return false;
+    }
+    for (size_t i = 0; i < tags.Size(); i++) {
+        const char* tag = tags.Data()[i];
+        if (tag[0] == '\0' || strpbrk(tag, ",\r\n") != nullptr) {
+            Napi::TypeError::New(env, "Node tags must be non-empty and contain no commas or line breaks")
+                .ThrowAsJavaScriptException();
+            return false;
+        }
+    }
+    return true;
+}
+
+// The optional node tags argument of a request, an array or a node tag set, as
+// the value of an x-confsec-node-tags header
+class NodeTagsArg {
+public:
+    // Returns false with a JS exception pending if the argument is invalid
+    bool Read(const Napi::CallbackInfo& info, size_t index) {
+        Napi::Env env = info.Env();
+        if (info.Length() <= index || info[index].IsUndefined() || info[index].IsNull()) {
+            return true;
+        }
+        NodeTagSet* tagSet = GetNodeTagSet(info[index]);
+        if (tagSet != nullptr) {
+            data = tagSet->header.data();
+            length = tagSet->header.length();
+            return true;
+        }
+        if (!info[index].IsArray()) {
+            Napi::TypeError::New(env, "Node tags must be an array or node tag set").ThrowAsJavaScriptException();
+            return false;
+        }
+        if (!ReadNodeTags(env, info[index].As<Napi::Array>(), decoded)) {
+            return false;
+        }
+        decoded.Join();
+        data = decoded.Bytes();
+        length = decoded.JoinedLength();
+        return true;
+    }
+
+    bool Empty() const { return length == 0; }
+    const char* Data() const { return data; }
+    size_t Length() const { return length; }
+
+private:
+    Utf8StringArray decoded;
+    const char* data = nullptr;
+    size_t length = 0;
+};
+
+// Find the next CRLF in [from, end), or return end
+const char* FindLineEnd(const char* from, const char* end) {
+    while (from < end) {
+        const char* cr = static_cast<const char*>(memchr(from, '\r', end - from));
+        if (cr == nullptr || cr + 1 >= end) {
+            return end;
+        }
+        if (cr[1] == '\n') {
+            return cr;
+        }
+        from = cr + 1;
+    }
+    return end;
+}
+
+// Copy a serialized request into result with node tags added to its
+// x-confsec-node-tags header, which is created after the request line if the
+// request has none. Returns false, leaving result alone, if the request line
+// isn't terminated.
+bool WithNodeTags(const char* request, size_t length, const NodeTagsArg& tags, string& result) {
+    static const char kHeader[] = "x-confsec-node-tags:";
+    static const size_t kHeaderLength = sizeof(kHeader) - 1;
+
+    const char* end = request + length;
+    const char* lineEnd = FindLineEnd(request, end);
+    if (lineEnd == end) {
+        return false;
+    }
+    const char* requestLineEnd = lineEnd + 2;
+    const char* insertAt = requestLineEnd;
+    bool newHeader = true;
+    bool hasValue = false;
+    for (const char* lineStart = requestLineEnd; ; lineStart = lineEnd + 2) {
+        lineEnd = FindLineEnd(lineStart, end);
+        if (lineEnd == end || lineEnd == lineStart) {
+            break;
+        }
+        bool isTagsHeader = static_cast<size_t>(lineEnd - lineStart) >= kHeaderLength &&
+            equal(kHeader, kHeader + kHeaderLength, lineStart,
+                  [](char a, char b) { return a == tolower(static_cast<unsigned char>(b)); });
+        if (isTagsHeader) {
+            const char* valueEnd = lineEnd;
+            while (valueEnd > lineStart + kHeaderLength && (valueEnd[-1] == ' ' || valueEnd[-1] == '\t')) {
+                valueEnd--;
+            }
+            insertAt = lineEnd;
+            newHeader = false;
+            hasValue = valueEnd > lineStart + kHeaderLength;
+            break;
+        }
+    }
+
+    result.clear();
+    result.reserve(length + kHeaderLength + tags.Length() + 4);
+    result.append(request, insertAt - request);
+    if (newHeader) {
+        result.append(kHeader, kHeaderLength).append(1, ' ');
+    } else if (hasValue) {
+        result.append(1, ',');
+    }
+    result.append(tags.Data(), tags.Length());
+    if (newHeader) {
+        result.append("\r\n", 2);
+    }
+    result.append(insertAt, end - insertAt);
+    return true;
+}
+
+// Add node tags to a request, throwing if they can't be added so that the
+// request isn't sent without them
+bool AddNodeTags(Napi::Env env, const char* request, size_t length, const NodeTagsArg& tags, string& result) {
+    if (!WithNodeTags(request, length, tags, result)) {
+        Napi::TypeError::New(env, "Request must have a request line to add node tags to")
+            .ThrowAsJavaScriptException();
+        return false;
+    }
+    return true;
 }
 
 // Wrapper functions
 Napi::Value ConfsecClientCreate(const Napi::CallbackInfo& info) {
+    TIME_CALL(kCallClientCreate);
     INIT_ERROR;
 
     Napi::Env env = info.Env();
     if (info.Length() < 11) {
-        Napi::TypeError::New(env, "Expected 5 arguments").ThrowAsJavaScriptException();
+        Napi::TypeError::New(env, "Expected 11 arguments").ThrowAsJavaScriptException();
         return env.Undefined();
     }
 
@@ -88,62 +893,61 @@ Napi::Value ConfsecClientCreate(const Napi::CallbackInfo& info) {
         Napi::TypeError::New(env, "Default node tags must be an array").ThrowAsJavaScriptException();
         return env.Undefined();
     }
-    if (!info[10].IsString() && !info[4].IsNull()) {
+    if (!info[10].IsString() && !info[10].IsNull()) {
         Napi::TypeError::New(env, "Environment must be a string or null").ThrowAsJavaScriptException();
         return env.Undefined();
     }
 
-    string apiUrl = info[0].As<Napi::String>().Utf8Value();
-    string apiKey = info[1].As<Napi::String>().Utf8Value();
+    Utf8String apiUrl(env, info[0]);
+    Utf8String apiKey(env, info[1]);
     int identityPolicySource = info[2].As<Napi::Number>().Int32Value();
-    string oidcIssuer = info[3].As<Napi::String>().Utf8Value();
-    string oidcIssuerRegex = info[4].As<Napi::String>().Utf8Value();
-    string oidcSubject = info[5].As<Napi::String>().Utf8Value();
-    string oidcSubjectRegex = info[6].As<Napi::String>().Utf8Value();
+    Utf8String oidcIssuer(env, info[3]);
+    Utf8String oidcIssuerRegex(env, info[4]);
+    Utf8String oidcSubject(env, info[5]);
+    Utf8String oidcSubjectRegex(env, info[6]);
     int concurrentRequestsTarget = info[7].As<Napi::Number>().Int32Value();
     int maxCandidateNodes = info[8].As<Napi::Number>().Int32Value();
-    Napi::Array defaultNodeTagsArray = info[9].As<Napi::Array>();
-    
-    vector<char*> defaultNodeTags = JSArrayToCStringArray(defaultNodeTagsArray);
-    
+    Utf8StringArray defaultNodeTags;
+    if (!defaultNodeTags.Decode(env, info[9].As<Napi::Array>())) {
+        return env.Undefined();
+    }
+
+    Utf8String envName;
     char* env_param = nullptr;
     if (info[10].IsString()) {
-        string envStr = info[10].As<Napi::String>().Utf8Value();
-        env_param = new char[envStr.length() + 1];
-        strcpy(env_param, envStr.c_str());
+        envName.Decode(env, info[10]);
+        env_param = envName.Data();
     }
 
     uintptr_t handle = Confsec_ClientCreate(
-        const_cast<char*>(apiUrl.c_str()),
-        const_cast<char*>(apiKey.c_str()),
+        apiUrl.Data(),
+        apiKey.Data(),
         identityPolicySource,
-        const_cast<char*>(oidcIssuer.c_str()),
-        const_cast<char*>(oidcIssuerRegex.c_str()),
-        const_cast<char*>(oidcSubject.c_str()),
-        const_cast<char*>(oidcSubjectRegex.c_str()),
+        oidcIssuer.Data(),
+        oidcIssuerRegex.Data(),
+        oidcSubject.Data(),
+        oidcSubjectRegex.Data(),
         concurrentRequestsTarget,
         maxCandidateNodes,
-        defaultNodeTags.data(),
-        defaultNodeTags.size(),
+        defaultNodeTags.Data(),
+        defaultNodeTags.Size(),
         env_param,
         &err
     );
-
-    // Clean up
-    FreeCStringArray(defaultNodeTags);
-    if (env_param) delete[] env_param;
-
     HANDLE_ERROR(env, err);
 
     if (handle == 0) {
-        Napi::Error::New(env, "Unexpected error creating client").ThrowAsJavaScriptException();
+        ConfsecError(env, "Unexpected error creating client").ThrowAsJavaScriptException();
         return env.Undefined();
     }
+    Add(stats.liveClients, 1);
+    TrackHandle("client", handle, CaptureStack(env));
 
     return Napi::Number::New(env, static_cast<double>(handle));
 }
 
 Napi::Value ConfsecClientDestroy(const Napi::CallbackInfo& info) {
+    TIME_CALL(kCallClientDestroy);
     Napi::Env env = info.Env();
     INIT_ERROR;
 
@@ -154,13 +958,19 @@ Napi::Value ConfsecClientDestroy(const Napi::CallbackInfo& info) {
 
     uintptr_t handle = static_cast<uintptr_t>(info[0].As<Napi::Number>().DoubleValue());
     
+    // The refresher thread uses the client, so this waits for a refresh in
+    // flight unless the refresh was stopped with confsecClientStopWalletRefresh
+    env.GetInstanceData<AddonData>()->walletRefreshers.erase(handle);
     Confsec_ClientDestroy(handle, &err);
     HANDLE_ERROR(env, err);
+    Add(stats.liveClients, -1);
+    UntrackHandle("client", handle);
 
     return env.Undefined();
 }
 
 Napi::Value ConfsecClientGetDefaultCreditAmountPerRequest(const Napi::CallbackInfo& info) {
+    TIME_CALL(kCallClientGetDefaultCreditAmountPerRequest);
     Napi::Env env = info.Env();
     INIT_ERROR;
 
@@ -178,6 +988,7 @@ Napi::Value ConfsecClientGetDefaultCreditAmountPerRequest(const Napi::CallbackIn
 }
 
 Napi::Value ConfsecClientGetMaxCandidateNodes(const Napi::CallbackInfo& info) {
+    TIME_CALL(kCallClientGetMaxCandidateNodes);
     Napi::Env env = info.Env();
     INIT_ERROR;
 
@@ -195,6 +1006,7 @@ Napi::Value ConfsecClientGetMaxCandidateNodes(const Napi::CallbackInfo& info) {
 }
 
 Napi::Value ConfsecClientGetDefaultNodeTags(const Napi::CallbackInfo& info) {
+    TIME_CALL(kCallClientGetDefaultNodeTags);
     Napi::Env env = info.Env();
     INIT_ERROR;
 
@@ -206,6 +1018,8 @@ Napi::Value ConfsecClientGetDefaultNodeTags(const Napi::CallbackInfo& info) {
     uintptr_t handle = static_cast<uintptr_t>(info[0].As<Napi::Number>().DoubleValue());
     
     size_t defaultNodeTagsCount;
+    // Whether the caller owns the returned array isn't documented by
+    // libconfsec, so it is left alone rather than risk freeing it twice
     char** defaultNodeTags = Confsec_ClientGetDefaultNodeTags(handle, &defaultNodeTagsCount, &err);
     HANDLE_ERROR(env, err);
 
@@ -218,28 +1032,62 @@ Napi::Value ConfsecClientGetDefaultNodeTags(const Napi::CallbackInfo& info) {
 }
 
 Napi::Value ConfsecClientSetDefaultNodeTags(const Napi::CallbackInfo& info) {
+    TIME_CALL(kCallClientSetDefaultNodeTags);
     Napi::Env env = info.Env();
     INIT_ERROR;
 
-    if (info.Length() < 2 || !info[0].IsNumber() || !info[1].IsArray()) {
-        Napi::TypeError::New(env, "Expected handle as number and tags as array").ThrowAsJavaScriptException();
+    NodeTagSet* tagSet = info.Length() < 2 ? nullptr : GetNodeTagSet(info[1]);
+    if (info.Length() < 2 || !info[0].IsNumber() || (!info[1].IsArray() && tagSet == nullptr)) {
+        Napi::TypeError::New(env, "Expected handle as number and tags as array or node tag set").ThrowAsJavaScriptException();
         return env.Undefined();
     }
 
     uintptr_t handle = static_cast<uintptr_t>(info[0].As<Napi::Number>().DoubleValue());
-    Napi::Array defaultNodeTagsArray = info[1].As<Napi::Array>();
-    
-    vector<char*> defaultNodeTags = JSArrayToCStringArray(defaultNodeTagsArray);
-    
-    Confsec_ClientSetDefaultNodeTags(handle, defaultNodeTags.data(), defaultNodeTags.size(), &err);
-    
-    FreeCStringArray(defaultNodeTags);
+    if (tagSet != nullptr) {
+        Confsec_ClientSetDefaultNodeTags(handle, tagSet->tagPointers.data(), tagSet->tagPointers.size(), &err);
+        HANDLE_ERROR(env, err);
+        return env.Undefined();
+    }
+    Utf8StringArray defaultNodeTags;
+    if (!defaultNodeTags.Decode(env, info[1].As<Napi::Array>())) {
+        return env.Undefined();
+    }
+
+    Confsec_ClientSetDefaultNodeTags(handle, defaultNodeTags.Data(), defaultNodeTags.Size(), &err);
     HANDLE_ERROR(env, err);
 
     return env.Undefined();
 }
 
+Napi::Value ConfsecNodeTagSetCreate(const Napi::CallbackInfo& info) {
+    TIME_CALL(kCallNodeTagSetCreate);
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsArray()) {
+        Napi::TypeError::New(env, "Expected tags as array").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    Utf8StringArray tags;
+    if (!ReadNodeTags(env, info[0].As<Napi::Array>(), tags)) {
+        return env.Undefined();
+    }
+    NodeTagSet* tagSet = new NodeTagSet();
+    tagSet->tags.assign(tags.Data(), tags.Data() + tags.Size());
+    for (string& tag : tagSet->tags) {
+        tagSet->tagPointers.push_back(&tag[0]);
+    }
+    tags.Join();
+    tagSet->header.assign(tags.Bytes(), tags.JoinedLength());
+
+    Napi::External<NodeTagSet> external = Napi::External<NodeTagSet>::New(
+        env, tagSet, [](Napi::Env, NodeTagSet* tagSet) { delete tagSet; });
+    external.TypeTag(&kNodeTagSetTypeTag);
+    return external;
+}
+
 Napi::Value ConfsecClientGetWalletStatus(const Napi::CallbackInfo& info) {
+    TIME_CALL(kCallClientGetWalletStatus);
     Napi::Env env = info.Env();
     INIT_ERROR;
 
@@ -259,7 +1107,91 @@ Napi::Value ConfsecClientGetWalletStatus(const Napi::CallbackInfo& info) {
     return result;
 }
 
+Napi::Value ConfsecClientStartWalletRefresh(const Napi::CallbackInfo& info) {
+    TIME_CALL(kCallClientStartWalletRefresh);
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 2 || !info[0].IsNumber() || !info[1].IsNumber() || info[1].As<Napi::Number>().DoubleValue() < 1) {
+        Napi::TypeError::New(env, "Expected handle as number and interval as positive number").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    uintptr_t handle = static_cast<uintptr_t>(info[0].As<Napi::Number>().DoubleValue());
+    int64_t intervalMs = static_cast<int64_t>(info[1].As<Napi::Number>().DoubleValue());
+
+    // Replacing a refresher waits for a refresh in flight of the previous one
+    unique_ptr<WalletRefresher>& refresher = env.GetInstanceData<AddonData>()->walletRefreshers[handle];
+    refresher.reset();
+    refresher.reset(new WalletRefresher(handle, intervalMs));
+    return env.Undefined();
+}
+
+Napi::Value ConfsecClientReadWallet(const Napi::CallbackInfo& info) {
+    TIME_CALL(kCallClientReadWallet);
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 2 || !info[0].IsNumber() || !info[1].IsTypedArray() ||
+        info[1].As<Napi::TypedArray>().TypedArrayType() != napi_float64_array ||
+        info[1].As<Napi::TypedArray>().ElementLength() < WalletRefresher::kValueCount) {
+        Napi::TypeError::New(env, "Expected handle as number and status as Float64Array of 3 elements").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    uintptr_t handle = static_cast<uintptr_t>(info[0].As<Napi::Number>().DoubleValue());
+    Napi::Float64Array status = info[1].As<Napi::Float64Array>();
+
+    AddonData* data = env.GetInstanceData<AddonData>();
+    auto found = data->walletRefreshers.find(handle);
+    bool read = found != data->walletRefreshers.end() && found->second->Read(status.Data());
+    return Napi::Boolean::New(env, read);
+}
+
+Napi::Value ConfsecClientRefreshWallet(const Napi::CallbackInfo& info) {
+    TIME_CALL(kCallClientRefreshWallet);
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsNumber()) {
+        Napi::TypeError::New(env, "Expected handle as number").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    uintptr_t handle = static_cast<uintptr_t>(info[0].As<Napi::Number>().DoubleValue());
+
+    AddonData* data = env.GetInstanceData<AddonData>();
+    auto found = data->walletRefreshers.find(handle);
+    if (found != data->walletRefreshers.end()) {
+        found->second->Nudge();
+    }
+    return env.Undefined();
+}
+
+Napi::Value ConfsecClientStopWalletRefresh(const Napi::CallbackInfo& info) {
+    TIME_CALL(kCallClientStopWalletRefresh);
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsNumber()) {
+        Napi::TypeError::New(env, "Expected handle as number").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    uintptr_t handle = static_cast<uintptr_t>(info[0].As<Napi::Number>().DoubleValue());
+
+    AddonData* data = env.GetInstanceData<AddonData>();
+    auto found = data->walletRefreshers.find(handle);
+    if (found == data->walletRefreshers.end()) {
+        Napi::Promise::Deferred deferred = Napi::Promise::Deferred::New(env);
+        deferred.Resolve(env.Undefined());
+        return deferred.Promise();
+    }
+    WalletRefreshStopWorker* worker = new WalletRefreshStopWorker(env, std::move(found->second));
+    data->walletRefreshers.erase(found);
+    Napi::Promise promise = worker->Promise();
+    worker->Queue();
+    return promise;
+}
+
 Napi::Value ConfsecClientDoRequest(const Napi::CallbackInfo& info) {
+    TIME_CALL(kCallClientDoRequest);
     Napi::Env env = info.Env();
     INIT_ERROR;
 
@@ -273,28 +1205,196 @@ Napi::Value ConfsecClientDoRequest(const Napi::CallbackInfo& info) {
     char* request;
     size_t requestLength;
     
+    Utf8String requestStr;
     if (info[1].IsString()) {
-        string requestStr = info[1].As<Napi::String>().Utf8Value();
-        request = const_cast<char*>(requestStr.c_str());
-        requestLength = requestStr.length();
+        requestStr.Decode(env, info[1]);
+        request = requestStr.Data();
+        requestLength = requestStr.Length();
     } else {
         Napi::Buffer<char> requestBuffer = info[1].As<Napi::Buffer<char>>();
         request = requestBuffer.Data();
         requestLength = requestBuffer.Length();
     }
 
+    NodeTagsArg nodeTags;
+    if (!nodeTags.Read(info, 2)) {
+        return env.Undefined();
+    }
+    Scratch<string> taggedRequest;
+    if (!nodeTags.Empty()) {
+        if (!AddNodeTags(env, request, requestLength, nodeTags, *taggedRequest)) {
+            return env.Undefined();
+        }
+        request = &(*taggedRequest)[0];
+        requestLength = taggedRequest->length();
+    }
+
+    Add(stats.requests, 1);
+    Add(stats.inFlightRequests, 1);
+    Add(stats.nativeBytesOutstanding, requestLength);
+    uint64_t requestId = nextRequestId.fetch_add(1, memory_order_relaxed);
+    PROBE_REQUEST_START(requestId, handle, requestLength);
     uintptr_t responseHandle = Confsec_ClientDoRequest(handle, request, requestLength, &err);
+    PROBE_REQUEST_END(requestId, responseHandle, err != nullptr || responseHandle == 0);
+    Add(stats.inFlightRequests, -1);
+    Add(stats.nativeBytesOutstanding, -static_cast<int64_t>(requestLength));
     HANDLE_ERROR(env, err);
 
     if (responseHandle == 0) {
-        Napi::Error::New(env, "Unexpected request failure").ThrowAsJavaScriptException();
+        ConfsecError(env, "Unexpected request failure").ThrowAsJavaScriptException();
         return env.Undefined();
     }
+    Add(stats.liveResponses, 1);
+    TrackHandle("response", responseHandle, CaptureStack(env));
 
     return Napi::Number::New(env, static_cast<double>(responseHandle));
 }
 
+// Runs Confsec_ClientDoRequest on the libuv thread pool and settles a promise
+// with the response handle
+class DoRequestWorker : public Napi::AsyncWorker {
+public:
+    DoRequestWorker(Napi::Env env, uintptr_t handle)
+        : Napi::AsyncWorker(env), deferred(Napi::Promise::Deferred::New(env)), handle(handle) {}
+
+    ~DoRequestWorker() {
+        if (requestRef.IsEmpty()) {
+            PROBE_BUFFER_FREE(requestData, requestLength);
+            ReturnScratch(requestCopy);
+        }
+    }
+
+    Napi::Promise Promise() { return deferred.Promise(); }
+
+    void Queue() {
+        Add(stats.requests, 1);
+        Add(stats.inFlightRequests, 1);
+        Add(stats.nativeBytesOutstanding, requestLength);
+        requestId = nextRequestId.fetch_add(1, memory_order_relaxed);
+        queuedNs = NowNs();
+        PROBE_REQUEST_START(requestId, handle, requestLength);
+        Napi::AsyncWorker::Queue();
+    }
+
+    // Set the JS stack the response will be tracked with
+    void SetStack(string stack) { this->stack = std::move(stack); }
+
+    // Take a copy of the request, for string requests whose UTF-8 bytes only
+    // exist transiently and requests with node tags added. It is given back to
+    // the scratch pool once done with.
+    void SetRequest(string request) {
+        requestCopy = std::move(request);
+        requestData = const_cast<char*>(requestCopy.data());
+        requestLength = requestCopy.length();
+        PROBE_BUFFER_ALLOC(requestData, requestLength);
+    }
+
+    // Reference a buffer request, which keeps its memory alive until we're done
+    void SetRequest(const Napi::Buffer<char>& request) {
+        requestRef = Napi::Persistent(request.As<Napi::Object>());
+        requestData = request.Data();
+        requestLength = request.Length();
+    }
+
+    void Execute() override {
+        char* err = nullptr;
+        executeStartNs = NowNs();
+        responseHandle = Confsec_ClientDoRequest(handle, requestData, requestLength, &err);
+        executeEndNs = NowNs();
+        PROBE_REQUEST_END(requestId, responseHandle, err != nullptr || responseHandle == 0);
+        TraceRecord("Confsec_ClientDoRequest", executeStartNs, executeEndNs);
+        if (err != nullptr) {
+            SetError(string(err));
+            free(err);
+        } else if (responseHandle == 0) {
+            SetError("Unexpected request failure");
+        }
+    }
+
+    void OnOK() override {
+        Settle();
+        Add(stats.liveResponses, 1);
+        TrackHandle("response", responseHandle, std::move(stack));
+        deferred.Resolve(Napi::Number::New(Env(), static_cast<double>(responseHandle)));
+    }
+
+    void OnError(const Napi::Error& error) override {
+        Settle();
+        deferred.Reject(ConfsecError(Env(), error.Message()).Value());
+    }
+
+private:
+    void Settle() {
+        TraceRecord("confsecClientDoRequestAsync queued", queuedNs, executeStartNs, requestId);
+        TraceRecord("confsecClientDoRequestAsync completion", executeEndNs, NowNs(), requestId);
+        Add(stats.inFlightRequests, -1);
+        Add(stats.nativeBytesOutstanding, -static_cast<int64_t>(requestLength));
+    }
+
+    Napi::Promise::Deferred deferred;
+    uintptr_t handle;
+    string requestCopy;
+    Napi::ObjectReference requestRef;
+    char* requestData = nullptr;
+    size_t requestLength = 0;
+    uintptr_t responseHandle = 0;
+    string stack;
+    uint64_t requestId = 0;
+    int64_t queuedNs = 0;
+    int64_t executeStartNs = 0;
+    int64_t executeEndNs = 0;
+};
+
+Napi::Value ConfsecClientDoRequestAsync(const Napi::CallbackInfo& info) {
+    TIME_CALL(kCallClientDoRequestAsync);
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 2 || !info[0].IsNumber() || (!info[1].IsString() && !info[1].IsBuffer())) {
+        Napi::TypeError::New(env, "Expected handle as number and request as string or buffer").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    uintptr_t handle = static_cast<uintptr_t>(info[0].As<Napi::Number>().DoubleValue());
+
+    NodeTagsArg nodeTags;
+    if (!nodeTags.Read(info, 2)) {
+        return env.Undefined();
+    }
+
+    Utf8String requestStr;
+    const char* request;
+    size_t requestLength;
+    if (info[1].IsString()) {
+        requestStr.Decode(env, info[1]);
+        request = requestStr.Data();
+        requestLength = requestStr.Length();
+    } else {
+        Napi::Buffer<char> requestBuffer = info[1].As<Napi::Buffer<char>>();
+        request = requestBuffer.Data();
+        requestLength = requestBuffer.Length();
+    }
+    Scratch<string> taggedRequest;
+    if (!nodeTags.Empty() && !AddNodeTags(env, request, requestLength, nodeTags, *taggedRequest)) {
+        return env.Undefined();
+    }
+
+    DoRequestWorker* worker = new DoRequestWorker(env, handle);
+    if (!nodeTags.Empty()) {
+        worker->SetRequest(taggedRequest.Release());
+    } else if (info[1].IsString()) {
+        worker->SetRequest(requestStr.Release());
+    } else {
+        worker->SetRequest(info[1].As<Napi::Buffer<char>>());
+    }
+    Napi::Promise promise = worker->Promise();
+    worker->SetStack(CaptureStack(env));
+    worker->Queue();
+
+    return promise;
+}
+
 Napi::Value ConfsecResponseDestroy(const Napi::CallbackInfo& info) {
+    TIME_CALL(kCallResponseDestroy);
     Napi::Env env = info.Env();
     INIT_ERROR;
 
@@ -307,11 +1407,14 @@ Napi::Value ConfsecResponseDestroy(const Napi::CallbackInfo& info) {
     
     Confsec_ResponseDestroy(handle, &err);
     HANDLE_ERROR(env, err);
+    Add(stats.liveResponses, -1);
+    UntrackHandle("response", handle);
 
     return env.Undefined();
 }
 
 Napi::Value ConfsecResponseGetMetadata(const Napi::CallbackInfo& info) {
+    TIME_CALL(kCallResponseGetMetadata);
     Napi::Env env = info.Env();
     INIT_ERROR;
 
@@ -326,7 +1429,7 @@ Napi::Value ConfsecResponseGetMetadata(const Napi::CallbackInfo& info) {
     HANDLE_ERROR(env, err);
 
     if (metadata == nullptr) {
-        Napi::Error::New(env, "Unexpected error getting request metadata").ThrowAsJavaScriptException();
+        ConfsecError(env, "Unexpected error getting request metadata").ThrowAsJavaScriptException();
         return env.Undefined();
     }
 
@@ -337,6 +1440,7 @@ Napi::Value ConfsecResponseGetMetadata(const Napi::CallbackInfo& info) {
 }
 
 Napi::Value ConfsecResponseIsStreaming(const Napi::CallbackInfo& info) {
+    TIME_CALL(kCallResponseIsStreaming);
     Napi::Env env = info.Env();
     INIT_ERROR;
 
@@ -354,6 +1458,7 @@ Napi::Value ConfsecResponseIsStreaming(const Napi::CallbackInfo& info) {
 }
 
 Napi::Value ConfsecResponseGetBody(const Napi::CallbackInfo& info) {
+    TIME_CALL(kCallResponseGetBody);
     Napi::Env env = info.Env();
     INIT_ERROR;
 
@@ -368,17 +1473,22 @@ Napi::Value ConfsecResponseGetBody(const Napi::CallbackInfo& info) {
     HANDLE_ERROR(env, err);
 
     if (body == nullptr) {
-        Napi::Error::New(env, "Unexpected error getting request body").ThrowAsJavaScriptException();
+        ConfsecError(env, "Unexpected error getting request body").ThrowAsJavaScriptException();
         return env.Undefined();
     }
 
-    Napi::Buffer<char> result = Napi::Buffer<char>::Copy(env, body, strlen(body));
+    size_t bodyLength = strlen(body);
+    PROBE_BUFFER_ALLOC(body, bodyLength);
+    Napi::Buffer<char> result = Napi::Buffer<char>::Copy(env, body, bodyLength);
+    PROBE_BUFFER_FREE(body, bodyLength);
     Confsec_Free(body);
+    Add(stats.bytesDelivered, bodyLength);
 
     return result;
 }
 
 Napi::Value ConfsecResponseGetStream(const Napi::CallbackInfo& info) {
+    TIME_CALL(kCallResponseGetStream);
     Napi::Env env = info.Env();
     INIT_ERROR;
 
@@ -393,14 +1503,17 @@ Napi::Value ConfsecResponseGetStream(const Napi::CallbackInfo& info) {
     HANDLE_ERROR(env, err);
 
     if (streamHandle == 0) {
-        Napi::Error::New(env, "Unexpected error getting response stream").ThrowAsJavaScriptException();
+        ConfsecError(env, "Unexpected error getting response stream").ThrowAsJavaScriptException();
         return env.Undefined();
     }
+    Add(stats.openStreams, 1);
+    TrackHandle("stream", streamHandle, CaptureStack(env));
 
     return Napi::Number::New(env, static_cast<double>(streamHandle));
 }
 
 Napi::Value ConfsecResponseStreamGetNext(const Napi::CallbackInfo& info) {
+    TIME_CALL(kCallResponseStreamGetNext);
     Napi::Env env = info.Env();
     INIT_ERROR;
 
@@ -418,13 +1531,98 @@ Napi::Value ConfsecResponseStreamGetNext(const Napi::CallbackInfo& info) {
         return env.Null(); // No more chunks
     }
 
-    Napi::Buffer<char> result = Napi::Buffer<char>::Copy(env, chunk, strlen(chunk));
+    size_t chunkLength = strlen(chunk);
+    PROBE_BUFFER_ALLOC(chunk, chunkLength);
+    PROBE_STREAM_CHUNK(handle, chunkLength);
+    Napi::Buffer<char> result = Napi::Buffer<char>::Copy(env, chunk, chunkLength);
+    PROBE_BUFFER_FREE(chunk, chunkLength);
     Confsec_Free(chunk);
+    Add(stats.chunks, 1);
+    Add(stats.bytesDelivered, chunkLength);
 
     return result;
 }
 
+// Runs Confsec_ResponseStreamGetNext on the libuv thread pool and settles a
+// promise with the chunk, timestamped when libconfsec returned it
+class StreamGetNextWorker : public Napi::AsyncWorker {
+public:
+    StreamGetNextWorker(Napi::Env env, uintptr_t handle)
+        : Napi::AsyncWorker(env), deferred(Napi::Promise::Deferred::New(env)), handle(handle) {}
+
+    ~StreamGetNextWorker() {
+        if (chunk != nullptr) {
+            Confsec_Free(chunk);
+        }
+    }
+
+    Napi::Promise Promise() { return deferred.Promise(); }
+
+    void Execute() override {
+        char* err = nullptr;
+        int64_t startNs = NowNs();
+        chunk = Confsec_ResponseStreamGetNext(handle, &err);
+        receivedNs = NowNs();
+        TraceRecord("Confsec_ResponseStreamGetNext", startNs, receivedNs);
+        if (err != nullptr) {
+            SetError(string(err));
+            free(err);
+        } else if (chunk != nullptr) {
+            chunkLength = strlen(chunk);
+            PROBE_BUFFER_ALLOC(chunk, chunkLength);
+            PROBE_STREAM_CHUNK(handle, chunkLength);
+        }
+    }
+
+    void OnOK() override {
+        Napi::Env env = Env();
+        Napi::Object result = Napi::Object::New(env);
+        if (chunk == nullptr) {
+            result.Set("chunk", env.Null()); // No more chunks
+        } else {
+            result.Set("chunk", Napi::Buffer<char>::Copy(env, chunk, chunkLength));
+            PROBE_BUFFER_FREE(chunk, chunkLength);
+            Confsec_Free(chunk);
+            chunk = nullptr;
+            Add(stats.chunks, 1);
+            Add(stats.bytesDelivered, chunkLength);
+        }
+        // Time the chunk waited for the JS thread since libconfsec returned it
+        result.Set("delayMs", Napi::Number::New(env, (NowNs() - receivedNs) / 1e6));
+        deferred.Resolve(result);
+    }
+
+    void OnError(const Napi::Error& error) override {
+        deferred.Reject(ConfsecError(Env(), error.Message()).Value());
+    }
+
+private:
+    Napi::Promise::Deferred deferred;
+    uintptr_t handle;
+    char* chunk = nullptr;
+    size_t chunkLength = 0;
+    int64_t receivedNs = 0;
+};
+
+Napi::Value ConfsecResponseStreamGetNextAsync(const Napi::CallbackInfo& info) {
+    TIME_CALL(kCallResponseStreamGetNextAsync);
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsNumber()) {
+        Napi::TypeError::New(env, "Expected handle as number").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    uintptr_t handle = static_cast<uintptr_t>(info[0].As<Napi::Number>().DoubleValue());
+
+    StreamGetNextWorker* worker = new StreamGetNextWorker(env, handle);
+    Napi::Promise promise = worker->Promise();
+    worker->Queue();
+    return promise;
+}
+
 Napi::Value ConfsecResponseStreamDestroy(const Napi::CallbackInfo& info) {
+    TIME_CALL(kCallResponseStreamDestroy);
     Napi::Env env = info.Env();
     INIT_ERROR;
 
@@ -437,12 +1635,232 @@ Napi::Value ConfsecResponseStreamDestroy(const Napi::CallbackInfo& info) {
     
     Confsec_ResponseStreamDestroy(handle, &err);
     HANDLE_ERROR(env, err);
+    Add(stats.openStreams, -1);
+    UntrackHandle("stream", handle);
+
+    return env.Undefined();
+}
+
+Napi::Value ConfsecGetStats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    auto number = [env](const atomic<int64_t>& counter) {
+        return Napi::Number::New(env, static_cast<double>(counter.load(memory_order_relaxed)));
+    };
+
+    Napi::Object errors = Napi::Object::New(env);
+    for (size_t i = 0; i < kErrorCodeCount; i++) {
+        errors.Set(kErrorCodes[i], number(stats.errors[i]));
+    }
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("liveClients", number(stats.liveClients));
+    result.Set("inFlightRequests", number(stats.inFlightRequests));
+    result.Set("liveResponses", number(stats.liveResponses));
+    result.Set("openStreams", number(stats.openStreams));
+    result.Set("nativeBytesOutstanding", number(stats.nativeBytesOutstanding));
+    result.Set("requests", number(stats.requests));
+    result.Set("chunks", number(stats.chunks));
+    result.Set("bytesDelivered", number(stats.bytesDelivered));
+    result.Set("errors", errors);
+    return result;
+}
+
+Napi::Value ConfsecGetCallStats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    auto number = [env](const atomic<int64_t>& counter, double scale = 1) {
+        return Napi::Number::New(env, counter.load(memory_order_relaxed) * scale);
+    };
+
+    Napi::Object result = Napi::Object::New(env);
+    for (int id = 0; id < kCallCount; id++) {
+        const CallStats& call = callStats[id];
+        Napi::Array buckets = Napi::Array::New(env, kCallBucketCount);
+        for (int i = 0; i < kCallBucketCount; i++) {
+            buckets[i] = number(call.buckets[i]);
+        }
+        Napi::Object stats = Napi::Object::New(env);
+        stats.Set("calls", number(call.calls));
+        stats.Set("totalMs", number(call.totalNs, 1e-6));
+        stats.Set("maxMs", number(call.maxNs, 1e-6));
+        stats.Set("buckets", buckets);
+        result.Set(kCallNames[id], stats);
+    }
+    return result;
+}
+
+Napi::Value ConfsecResetCallStats(const Napi::CallbackInfo& info) {
+    for (CallStats& call : callStats) {
+        call.calls.store(0, memory_order_relaxed);
+        call.totalNs.store(0, memory_order_relaxed);
+        call.maxNs.store(0, memory_order_relaxed);
+        for (atomic<int64_t>& bucket : call.buckets) {
+            bucket.store(0, memory_order_relaxed);
+        }
+    }
+    return info.Env().Undefined();
+}
+
+Napi::Value ConfsecSetSlowCallHook(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 2 || !info[0].IsNumber() || (!info[1].IsFunction() && !info[1].IsNull())) {
+        Napi::TypeError::New(env, "Expected threshold as number and hook as function or null").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    AddonData* data = env.GetInstanceData<AddonData>();
+    if (data->slowCallThresholdNs > 0) {
+        data->slowCallHook.Release();
+        data->slowCallThresholdNs = 0;
+    }
+    if (info[1].IsFunction()) {
+        double thresholdMs = info[0].As<Napi::Number>().DoubleValue();
+        data->slowCallHook = Napi::ThreadSafeFunction::New(
+            env, info[1].As<Napi::Function>(), "confsecSlowCallHook", 0, 1);
+        // The hook must not keep the process alive
+        data->slowCallHook.Unref(env);
+        data->slowCallThresholdNs = max(static_cast<int64_t>(thresholdMs * 1e6), static_cast<int64_t>(1));
+    }
+
+    return env.Undefined();
+}
+
+Napi::Value ConfsecTraceStart(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
 
+    if (info.Length() < 1 || !info[0].IsNumber() || info[0].As<Napi::Number>().DoubleValue() < 1) {
+        Napi::TypeError::New(env, "Expected capacity as positive number").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    size_t capacity = static_cast<size_t>(info[0].As<Napi::Number>().DoubleValue());
+    lock_guard<mutex> lock(traceMutex);
+    if (tracing.load()) {
+        Napi::Error::New(env, "Tracing already started").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    TraceBuffer* buffer = traceBuffer.load(memory_order_acquire);
+    if (buffer == nullptr || buffer->capacity != capacity) {
+        unique_ptr<TraceBuffer> previous(buffer);
+        buffer = new TraceBuffer(capacity);
+        traceBuffer.store(buffer, memory_order_release);
+        // Wait out spans of the last trace still being written. Tracing is
+        // stopped, so no new span can start writing to the previous buffer.
+        while (traceWriters.load() != 0) {
+            this_thread::yield();
+        }
+    }
+    buffer->next.store(0, memory_order_relaxed);
+    tracing.store(true);
     return env.Undefined();
 }
 
+Napi::Value ConfsecTraceStop(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    lock_guard<mutex> lock(traceMutex);
+    tracing.store(false);
+    Napi::Array spans = Napi::Array::New(env);
+    TraceBuffer* buffer = traceBuffer.load(memory_order_acquire);
+    if (buffer != nullptr) {
+        uint64_t end = buffer->next.load(memory_order_relaxed);
+        uint64_t begin = end > buffer->capacity ? end - buffer->capacity : 0;
+        uint32_t count = 0;
+        for (uint64_t i = begin; i < end; i++) {
+            TraceSpan& span = buffer->spans[i % buffer->capacity];
+            uint64_t seq = span.seq.load(memory_order_acquire);
+            const char* name = span.name.load(memory_order_relaxed);
+            int64_t startNs = span.startNs.load(memory_order_relaxed);
+            int64_t endNs = span.endNs.load(memory_order_relaxed);
+            uint32_t tid = span.tid.load(memory_order_relaxed);
+            uint64_t id = span.id.load(memory_order_relaxed);
+            atomic_thread_fence(memory_order_acquire);
+            // Skip spans still being written, or overwritten while read
+            if (seq != i + 1 || span.seq.load(memory_order_relaxed) != seq) {
+                continue;
+            }
+            Napi::Object result = Napi::Object::New(env);
+            result.Set("name", Napi::String::New(env, name));
+            result.Set("tid", Napi::Number::New(env, tid));
+            result.Set("startUs", Napi::Number::New(env, startNs / 1e3));
+            result.Set("endUs", Napi::Number::New(env, endNs / 1e3));
+            result.Set("id", Napi::Number::New(env, static_cast<double>(id)));
+            spans[count++] = result;
+        }
+    }
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("nowUs", Napi::Number::New(env, NowNs() / 1e3));
+    result.Set("tid", Napi::Number::New(env, TraceTid()));
+    result.Set("spans", spans);
+    return result;
+}
+
+Napi::Value ConfsecTrackHandles(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsBoolean()) {
+        Napi::TypeError::New(env, "Expected enabled as boolean").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    lock_guard<mutex> lock(liveHandlesMutex);
+    if (info[0].As<Napi::Boolean>().Value()) {
+        handleTrackers.fetch_add(1);
+    } else if (handleTrackers.load() > 0 && handleTrackers.fetch_sub(1) == 1) {
+        liveHandles.clear();
+    }
+    return env.Undefined();
+}
+
+Napi::Value ConfsecGetLiveHandles(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    int64_t now = NowNs();
+    lock_guard<mutex> lock(liveHandlesMutex);
+    Napi::Array result = Napi::Array::New(env, liveHandles.size());
+    uint32_t i = 0;
+    for (const auto& entry : liveHandles) {
+        Napi::Object handle = Napi::Object::New(env);
+        handle.Set("kind", Napi::String::New(env, entry.first.first));
+        handle.Set("handle", Napi::Number::New(env, static_cast<double>(entry.first.second)));
+        handle.Set("ageMs", Napi::Number::New(env, (now - entry.second.createdNs) / 1e6));
+        handle.Set("stack", Napi::String::New(env, entry.second.stack));
+        result[i++] = handle;
+    }
+    return result;
+}
+
+#ifdef LIBCONFSEC_STUB
+Napi::Value ConfsecStubGetStats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    ConfsecStub_Stats stats;
+    ConfsecStub_GetStats(&stats);
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("requests", Napi::Number::New(env, static_cast<double>(stats.requests)));
+    result.Set("errors", Napi::Number::New(env, static_cast<double>(stats.errors)));
+    result.Set("chunks", Napi::Number::New(env, static_cast<double>(stats.chunks)));
+    result.Set("allocations", Napi::Number::New(env, static_cast<double>(stats.allocations)));
+    result.Set("frees", Napi::Number::New(env, static_cast<double>(stats.frees)));
+    result.Set("bytesAllocated", Napi::Number::New(env, static_cast<double>(stats.bytesAllocated)));
+    result.Set("liveHandles", Napi::Number::New(env, static_cast<double>(stats.liveHandles)));
+    return result;
+}
+
+Napi::Value ConfsecStubResetStats(const Napi::CallbackInfo& info) {
+    ConfsecStub_ResetStats();
+    return info.Env().Undefined();
+}
+#endif
+
 // Module initialization
 Napi::Object Init(Napi::Env env, Napi::Object exports) {
+    env.SetInstanceData(new AddonData());
+
     exports.Set(Napi::String::New(env, "confsecClientCreate"), 
                 Napi::Function::New(env, ConfsecClientCreate));
     exports.Set(Napi::String::New(env, "confsecClientDestroy"), 
@@ -455,10 +1873,22 @@ Napi::Object Init(Napi::Env env, Napi::Object exports) {
                 Napi::Function::New(env, ConfsecClientGetDefaultNodeTags));
     exports.Set(Napi::String::New(env, "confsecClientSetDefaultNodeTags"), 
                 Napi::Function::New(env, ConfsecClientSetDefaultNodeTags));
+    exports.Set(Napi::String::New(env, "confsecNodeTagSetCreate"), 
+                Napi::Function::New(env, ConfsecNodeTagSetCreate));
     exports.Set(Napi::String::New(env, "confsecClientGetWalletStatus"), 
                 Napi::Function::New(env, ConfsecClientGetWalletStatus));
+    exports.Set(Napi::String::New(env, "confsecClientStartWalletRefresh"), 
+                Napi::Function::New(env, ConfsecClientStartWalletRefresh));
+    exports.Set(Napi::String::New(env, "confsecClientReadWallet"), 
+                Napi::Function::New(env, ConfsecClientReadWallet));
+    exports.Set(Napi::String::New(env, "confsecClientRefreshWallet"), 
+                Napi::Function::New(env, ConfsecClientRefreshWallet));
+    exports.Set(Napi::String::New(env, "confsecClientStopWalletRefresh"), 
+                Napi::Function::New(env, ConfsecClientStopWalletRefresh));
     exports.Set(Napi::String::New(env, "confsecClientDoRequest"), 
                 Napi::Function::New(env, ConfsecClientDoRequest));
+    exports.Set(Napi::String::New(env, "confsecClientDoRequestAsync"), 
+                Napi::Function::New(env, ConfsecClientDoRequestAsync));
     exports.Set(Napi::String::New(env, "confsecResponseDestroy"), 
                 Napi::Function::New(env, ConfsecResponseDestroy));
     exports.Set(Napi::String::New(env, "confsecResponseGetMetadata"), 
@@ -471,8 +1901,32 @@ Napi::Object Init(Napi::Env env, Napi::Object exports) {
                 Napi::Function::New(env, ConfsecResponseGetStream));
     exports.Set(Napi::String::New(env, "confsecResponseStreamGetNext"), 
                 Napi::Function::New(env, ConfsecResponseStreamGetNext));
+    exports.Set(Napi::String::New(env, "confsecResponseStreamGetNextAsync"), 
+                Napi::Function::New(env, ConfsecResponseStreamGetNextAsync));
     exports.Set(Napi::String::New(env, "confsecResponseStreamDestroy"), 
                 Napi::Function::New(env, ConfsecResponseStreamDestroy));
+    exports.Set(Napi::String::New(env, "confsecGetStats"), 
+                Napi::Function::New(env, ConfsecGetStats));
+    exports.Set(Napi::String::New(env, "confsecGetCallStats"), 
+                Napi::Function::New(env, ConfsecGetCallStats));
+    exports.Set(Napi::String::New(env, "confsecResetCallStats"), 
+                Napi::Function::New(env, ConfsecResetCallStats));
+    exports.Set(Napi::String::New(env, "confsecSetSlowCallHook"), 
+                Napi::Function::New(env, ConfsecSetSlowCallHook));
+    exports.Set(Napi::String::New(env, "confsecTraceStart"), 
+                Napi::Function::New(env, ConfsecTraceStart));
+    exports.Set(Napi::String::New(env, "confsecTraceStop"), 
+                Napi::Function::New(env, ConfsecTraceStop));
+    exports.Set(Napi::String::New(env, "confsecTrackHandles"), 
+                Napi::Function::New(env, ConfsecTrackHandles));
+    exports.Set(Napi::String::New(env, "confsecGetLiveHandles"), 
+                Napi::Function::New(env, ConfsecGetLiveHandles));
+#ifdef LIBCONFSEC_STUB
+    exports.Set(Napi::String::New(env, "confsecStubGetStats"), 
+                Napi::Function::New(env, ConfsecStubGetStats));
+    exports.Set(Napi::String::New(env, "confsecStubResetStats"), 
+                Napi::Function::New(env, ConfsecStubResetStats));
+#endif
 
     return exports;
 }
@@ -0,0 +1,44 @@
+// USDT probes of the binding, under the "confsec" provider, for bpftrace,
+// perf and other SystemTap SDT consumers. A probe that is not enabled costs a
+// single nop, so probes are compiled in whenever <sys/sdt.h> is available,
+// unless CONFSEC_NO_PROBES is defined. Otherwise the macros do nothing.
+//
+//   request__start(uint64_t id, uintptr_t client, size_t length)
+//   request__end(uint64_t id, uintptr_t response, int failed)
+//   stream__chunk(uintptr_t stream, size_t length)
+//   buffer__alloc(const void* data, size_t length)
+//   buffer__free(const void* data, size_t length)
+//   error(const char* code, const char* message)
+//
+// Buffers are the bodies and chunks returned by libconfsec, and the copies of
+// string requests held for requests on the thread pool.
+
+#ifndef CONFSEC_PROBES_H
+#define CONFSEC_PROBES_H
+
+#if !defined(CONFSEC_NO_PROBES) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define CONFSEC_HAVE_PROBES 1
+#endif
+#endif
+
+#ifdef CONFSEC_HAVE_PROBES
+#define PROBE_REQUEST_START(id, client, length) DTRACE_PROBE3(confsec, request__start, id, client, length)
+#define PROBE_REQUEST_END(id, response, failed) DTRACE_PROBE3(confsec, request__end, id, response, failed)
+#define PROBE_STREAM_CHUNK(stream, length) DTRACE_PROBE2(confsec, stream__chunk, stream, length)
+#define PROBE_BUFFER_ALLOC(data, length) DTRACE_PROBE2(confsec, buffer__alloc, data, length)
+#define PROBE_BUFFER_FREE(data, length) DTRACE_PROBE2(confsec, buffer__free, data, length)
+#define PROBE_ERROR(code, message) DTRACE_PROBE2(confsec, error, code, message)
+#else
+// Arguments are still evaluated as void, so that variables only passed to
+// probes are not reported as unused
+#define PROBE_REQUEST_START(id, client, length) ((void)(id), (void)(client), (void)(length))
+#define PROBE_REQUEST_END(id, response, failed) ((void)(id), (void)(response), (void)(failed))
+#define PROBE_STREAM_CHUNK(stream, length) ((void)(stream), (void)(length))
+#define PROBE_BUFFER_ALLOC(data, length) ((void)(data), (void)(length))
+#define PROBE_BUFFER_FREE(data, length) ((void)(data), (void)(length))
+#define PROBE_ERROR(code, message) ((void)(code), (void)(message))
+#endif
+
+#endif // CONFSEC_PROBES_H
@@ -0,0 +1,58 @@
+// Stub implementation of the libconfsec API, for exercising the native binding
+// without network access or credentials. See libconfsec_stub.cc for the knobs
+// controlling its behaviour.
+
+#ifndef LIBCONFSEC_STUB_H
+#define LIBCONFSEC_STUB_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define LIBCONFSEC_STUB 1
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+uintptr_t Confsec_ClientCreate(char* apiUrl, char* apiKey, int identityPolicySource, char* oidcIssuer, char* oidcIssuerRegex, char* oidcSubject, char* oidcSubjectRegex, int concurrentRequestsTarget, int maxCandidateNodes, char** defaultNodeTags, size_t defaultNodeTagsCount, char* env, char** err);
+void Confsec_ClientDestroy(uintptr_t handle, char** err);
+long Confsec_ClientGetDefaultCreditAmountPerRequest(uintptr_t handle, char** err);
+int Confsec_ClientGetMaxCandidateNodes(uintptr_t handle, char** err);
+char** Confsec_ClientGetDefaultNodeTags(uintptr_t handle, size_t* defaultNodeTagsCount, char** err);
+void Confsec_ClientSetDefaultNodeTags(uintptr_t handle, char** defaultNodeTags, size_t defaultNodeTagsCount, char** err);
+char* Confsec_ClientGetWalletStatus(uintptr_t handle, char** err);
+uintptr_t Confsec_ClientDoRequest(uintptr_t handle, char* request, size_t requestLength, char** err);
+
+void Confsec_ResponseDestroy(uintptr_t handle, char** err);
+char* Confsec_ResponseGetMetadata(uintptr_t handle, char** err);
+bool Confsec_ResponseIsStreaming(uintptr_t handle, char** err);
+char* Confsec_ResponseGetBody(uintptr_t handle, char** err);
+uintptr_t Confsec_ResponseGetStream(uintptr_t handle, char** err);
+
+char* Confsec_ResponseStreamGetNext(uintptr_t handle, char** err);
+void Confsec_ResponseStreamDestroy(uintptr_t handle, char** err);
+
+void Confsec_Free(void* ptr);
+
+// Stub-only counters
+typedef struct {
+    uint64_t requests;
+    uint64_t errors;
+    uint64_t chunks;
+    // Strings handed to the caller, which must be released with Confsec_Free
+    uint64_t allocations;
+    uint64_t frees;
+    uint64_t bytesAllocated;
+    // Live client, response and stream handles
+    uint64_t liveHandles;
+} ConfsecStub_Stats;
+
+void ConfsecStub_GetStats(ConfsecStub_Stats* stats);
+void ConfsecStub_ResetStats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LIBCONFSEC_STUB_H
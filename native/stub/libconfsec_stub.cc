@@ -0,0 +1,476 @@
+// Stub implementation of the libconfsec API. Requests never leave the process:
+// responses are synthesized after an optional delay, which makes it possible
+// to load test and benchmark the real native binding offline.
+//
+// Behaviour is configured with environment variables, read when a client is
+// created, and can be overridden per request with the matching header:
+//
+//   CONFSEC_STUB_LATENCY_MS         x-confsec-stub-latency-ms
+//       Time Confsec_ClientDoRequest blocks for (default: 0)
+//   CONFSEC_STUB_LATENCY_JITTER_MS  x-confsec-stub-latency-jitter-ms
+//       Maximum random latency added on top (default: 0)
+//   CONFSEC_STUB_CREDIT_LATENCY_MS  x-confsec-stub-credit-latency-ms
+//       Latency added to requests made while more than the client's
+//       concurrentRequestsTarget are in flight, modelling credits being
+//       fetched on demand (default: 0)
+//   CONFSEC_STUB_STATUS             x-confsec-stub-status
+//       Response status code (default: 200)
+//   CONFSEC_STUB_BODY_BYTES         x-confsec-stub-body-bytes
+//       Approximate size of non-streaming bodies (default: 256)
+//   CONFSEC_STUB_STREAM             x-confsec-stub-stream
+//       1 to stream responses, 0 not to (default: stream when the request
+//       body contains "stream": true)
+//   CONFSEC_STUB_SSE                x-confsec-stub-sse
+//       1 to format chunks as OpenAI server-sent events, 0 for raw bytes
+//       (default: 1)
+//   CONFSEC_STUB_CHUNKS             x-confsec-stub-chunks
+//       Number of chunks per stream (default: 16)
+//   CONFSEC_STUB_CHUNK_BYTES        x-confsec-stub-chunk-bytes
+//       Approximate size of each chunk (default: 200)
+//   CONFSEC_STUB_CHUNK_INTERVAL_US  x-confsec-stub-chunk-interval-us
+//       Time Confsec_ResponseStreamGetNext blocks for per chunk (default: 0)
+//   CONFSEC_STUB_ERROR_RATE         x-confsec-stub-error-rate
+//       Fraction of requests that fail (default: 0)
+//   CONFSEC_STUB_ERROR              x-confsec-stub-error
+//       Message of injected request failures (default: "no nodes available")
+//   CONFSEC_STUB_STREAM_ERROR_AT    x-confsec-stub-stream-error-at
+//       Fail streams when reading this chunk, or -1 never to (default: -1)
+
+#include "libconfsec.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+const char kHeaderPrefix[] = "x-confsec-stub-";
+const char kEnvPrefix[] = "CONFSEC_STUB_";
+
+const long kCreditAmountPerRequest = 1000;
+const long kInitialCredits = 1000000000;
+
+struct StubConfig {
+    double latencyMs = 0;
+    double latencyJitterMs = 0;
+    double creditLatencyMs = 0;
+    int status = 200;
+    size_t bodyBytes = 256;
+    int stream = -1;
+    bool sse = true;
+    size_t chunks = 16;
+    size_t chunkBytes = 200;
+    double chunkIntervalUs = 0;
+    double errorRate = 0;
+    string error = "no nodes available";
+    long streamErrorAt = -1;
+};
+
+const char* const kOptions[] = {
+    "latency-ms", "latency-jitter-ms", "credit-latency-ms", "status",
+    "body-bytes", "stream", "sse", "chunks", "chunk-bytes",
+    "chunk-interval-us", "error-rate", "error", "stream-error-at",
+};
+
+struct StubClient {
+    StubConfig config;
+    int concurrentRequestsTarget;
+    int maxCandidateNodes;
+    atomic<int> inFlight{0};
+    mutex tagsMutex;
+    vector<string> defaultNodeTags;
+    atomic<long> creditsSpent{0};
+};
+
+struct StubResponse {
+    StubConfig config;
+    string metadata;
+    string body;
+    bool streaming;
+};
+
+struct StubStream {
+    StubConfig config;
+    size_t next = 0;
+};
+
+struct Counters {
+    atomic<uint64_t> requests{0};
+    atomic<uint64_t> errors{0};
+    atomic<uint64_t> chunks{0};
+    atomic<uint64_t> allocations{0};
+    atomic<uint64_t> frees{0};
+    atomic<uint64_t> bytesAllocated{0};
+    atomic<uint64_t> liveHandles{0};
+};
+
+Counters counters;
+
+void SetOption(StubConfig& config, const string& name, const string& value) {
+    if (name == "latency-ms") {
+        config.latencyMs = atof(value.c_str());
+    } else if (name == "latency-jitter-ms") {
+        config.latencyJitterMs = atof(value.c_str());
+    } else if (name == "credit-latency-ms") {
+        config.creditLatencyMs = atof(value.c_str());
+    } else if (name == "status") {
+        config.status = atoi(value.c_str());
+    } else if (name == "body-bytes") {
+        config.bodyBytes = strtoul(value.c_str(), nullptr, 10);
+    } else if (name == "stream") {
+        config.stream = atoi(value.c_str()) != 0;
+    } else if (name == "sse") {
+        config.sse = atoi(value.c_str()) != 0;
+    } else if (name == "chunks") {
+        config.chunks = strtoul(value.c_str(), nullptr, 10);
+    } else if (name == "chunk-bytes") {
+        config.chunkBytes = strtoul(value.c_str(), nullptr, 10);
+    } else if (name == "chunk-interval-us") {
+        config.chunkIntervalUs = atof(value.c_str());
+    } else if (name == "error-rate") {
+        config.errorRate = atof(value.c_str());
+    } else if (name == "error") {
+        config.error = value;
+    } else if (name == "stream-error-at") {
+        config.streamErrorAt = atol(value.c_str());
+    }
+}
+
+StubConfig ConfigFromEnv() {
+    StubConfig config;
+    for (const char* option : kOptions) {
+        string name = kEnvPrefix;
+        for (const char* c = option; *c; c++) {
+            name += *c == '-' ? '_' : static_cast<char>(toupper(*c));
+        }
+        const char* value = getenv(name.c_str());
+        if (value != nullptr) {
+            SetOption(config, option, value);
+        }
+    }
+    return config;
+}
+
+// Apply x-confsec-stub-* headers and detect streaming requests
+StubConfig ConfigForRequest(const StubConfig& base, const char* request, size_t length) {
+    StubConfig config = base;
+    string raw(request, length);
+    size_t headersEnd = raw.find("\r\n\r\n");
+    if (headersEnd == string::npos) {
+        headersEnd = raw.size();
+    }
+
+    // Skip the request line
+    size_t lineStart = raw.find("\r\n");
+    while (lineStart != string::npos && lineStart < headersEnd) {
+        lineStart += 2;
+        size_t lineEnd = raw.find("\r\n", lineStart);
+        if (lineEnd == string::npos) {
+            lineEnd = raw.size();
+        }
+        string line = raw.substr(lineStart, lineEnd - lineStart);
+        size_t colon = line.find(':');
+        if (colon != string::npos) {
+            string name = line.substr(0, colon);
+            transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return tolower(c); });
+            if (name.compare(0, sizeof(kHeaderPrefix) - 1, kHeaderPrefix) == 0) {
+                size_t valueStart = line.find_first_not_of(' ', colon + 1);
+                string value = valueStart == string::npos ? "" : line.substr(valueStart);
+                SetOption(config, name.substr(sizeof(kHeaderPrefix) - 1), value);
+            }
+        }
+        lineStart = lineEnd;
+    }
+
+    if (config.stream < 0) {
+        config.stream = 0;
+        size_t key = raw.find("\"stream\"", headersEnd);
+        if (key != string::npos) {
+            size_t value = raw.find_first_not_of(" \t\r\n:", key + 8);
+            config.stream = value != string::npos && raw.compare(value, 4, "true") == 0;
+        }
+    }
+    return config;
+}
+
+double RandomUnit() {
+    thread_local mt19937_64 rng{random_device{}()};
+    return uniform_real_distribution<double>(0, 1)(rng);
+}
+
+void SleepMs(double ms) {
+    if (ms > 0) {
+        this_thread::sleep_for(chrono::duration<double, milli>(ms));
+    }
+}
+
+void SetError(char** err, const string& message) {
+    counters.errors++;
+    // Released by the caller with free()
+    char* copy = static_cast<char*>(malloc(message.size() + 1));
+    memcpy(copy, message.c_str(), message.size() + 1);
+    *err = copy;
+}
+
+// Copy a string into memory the caller releases with Confsec_Free
+char* Dup(const string& value) {
+    counters.allocations++;
+    counters.bytesAllocated += value.size() + 1;
+    char* copy = static_cast<char*>(malloc(value.size() + 1));
+    memcpy(copy, value.c_str(), value.size() + 1);
+    return copy;
+}
+
+template <typename T>
+uintptr_t NewHandle(T* object) {
+    counters.liveHandles++;
+    return reinterpret_cast<uintptr_t>(object);
+}
+
+template <typename T>
+T* FromHandle(uintptr_t handle, char** err) {
+    if (handle == 0) {
+        SetError(err, "invalid handle");
+        return nullptr;
+    }
+    return reinterpret_cast<T*>(handle);
+}
+
+template <typename T>
+void DestroyHandle(uintptr_t handle, char** err) {
+    T* object = FromHandle<T>(handle, err);
+    if (object != nullptr) {
+        counters.liveHandles--;
+        delete object;
+    }
+}
+
+string Metadata(const StubConfig& config, bool streaming) {
+    const char* contentType = !streaming ? "application/json"
+        : config.sse ? "text/event-stream" : "application/octet-stream";
+    return string("{\"status_code\":") + to_string(config.status) +
+        ",\"reason_phrase\":\"" + (config.status == 200 ? "OK" : "Stub Status") +
+        "\",\"http_version\":\"HTTP/1.1\",\"url\":\"\",\"headers\":[" +
+        "{\"key\":\"content-type\",\"value\":\"" + contentType + "\"}]}";
+}
+
+// Pad a JSON template's content field so the whole document is about size bytes
+string Padded(const string& prefix, const string& suffix, size_t size) {
+    size_t overhead = prefix.size() + suffix.size();
+    return prefix + string(size > overhead ? size - overhead : 0, 'x') + suffix;
+}
+
+string Body(const StubConfig& config) {
+    return Padded(
+        "{\"id\":\"chatcmpl-stub\",\"object\":\"chat.completion\",\"created\":0,"
+        "\"model\":\"stub\",\"choices\":[{\"index\":0,\"message\":"
+        "{\"role\":\"assistant\",\"content\":\"",
+        "\"},\"finish_reason\":\"stop\"}],\"usage\":{\"prompt_tokens\":0,"
+        "\"completion_tokens\":0,\"total_tokens\":0}}",
+        config.bodyBytes);
+}
+
+string Chunk(const StubConfig& config) {
+    if (!config.sse) {
+        return string(config.chunkBytes, 'x');
+    }
+    return Padded(
+        "data: {\"id\":\"chatcmpl-stub\",\"object\":\"chat.completion.chunk\","
+        "\"created\":0,\"model\":\"stub\",\"choices\":[{\"index\":0,"
+        "\"delta\":{\"content\":\"",
+        "\"},\"finish_reason\":null}]}\n\n",
+        config.chunkBytes);
+}
+
+} // namespace
+
+extern "C" {
+
+uintptr_t Confsec_ClientCreate(char* apiUrl, char* apiKey, int identityPolicySource, char* oidcIssuer, char* oidcIssuerRegex, char* oidcSubject, char* oidcSubjectRegex, int concurrentRequestsTarget, int maxCandidateNodes, char** defaultNodeTags, size_t defaultNodeTagsCount, char* env, char** err) {
+    StubClient* client = new StubClient();
+    client->config = ConfigFromEnv();
+    client->concurrentRequestsTarget = concurrentRequestsTarget;
+    client->maxCandidateNodes = maxCandidateNodes;
+    for (size_t i = 0; i < defaultNodeTagsCount; i++) {
+        client->defaultNodeTags.emplace_back(defaultNodeTags[i]);
+    }
+    return NewHandle(client);
+}
+
+void Confsec_ClientDestroy(uintptr_t handle, char** err) {
+    DestroyHandle<StubClient>(handle, err);
+}
+
+long Confsec_ClientGetDefaultCreditAmountPerRequest(uintptr_t handle, char** err) {
+    return FromHandle<StubClient>(handle, err) ? kCreditAmountPerRequest : 0;
+}
+
+int Confsec_ClientGetMaxCandidateNodes(uintptr_t handle, char** err) {
+    StubClient* client = FromHandle<StubClient>(handle, err);
+    return client ? client->maxCandidateNodes : 0;
+}
+
+char** Confsec_ClientGetDefaultNodeTags(uintptr_t handle, size_t* defaultNodeTagsCount, char** err) {
+    *defaultNodeTagsCount = 0;
+    StubClient* client = FromHandle<StubClient>(handle, err);
+    if (client == nullptr) {
+        return nullptr;
+    }
+    lock_guard<mutex> lock(client->tagsMutex);
+    size_t count = client->defaultNodeTags.size();
+    counters.allocations++;
+    counters.bytesAllocated += count * sizeof(char*);
+    char** tags = static_cast<char**>(malloc(count * sizeof(char*)));
+    for (size_t i = 0; i < count; i++) {
+        tags[i] = Dup(client->defaultNodeTags[i]);
+    }
+    *defaultNodeTagsCount = count;
+    return tags;
+}
+
+void Confsec_ClientSetDefaultNodeTags(uintptr_t handle, char** defaultNodeTags, size_t defaultNodeTagsCount, char** err) {
+    StubClient* client = FromHandle<StubClient>(handle, err);
+    if (client == nullptr) {
+        return;
+    }
+    lock_guard<mutex> lock(client->tagsMutex);
+    client->defaultNodeTags.assign(defaultNodeTags, defaultNodeTags + defaultNodeTagsCount);
+}
+
+char* Confsec_ClientGetWalletStatus(uintptr_t handle, char** err) {
+    StubClient* client = FromHandle<StubClient>(handle, err);
+    if (client == nullptr) {
+        return nullptr;
+    }
+    long spent = client->creditsSpent.load();
+    return Dup("{\"credits_spent\":" + to_string(spent) +
+        ",\"credits_held\":0,\"credits_available\":" + to_string(kInitialCredits - spent) + "}");
+}
+
+uintptr_t Confsec_ClientDoRequest(uintptr_t handle, char* request, size_t requestLength, char** err) {
+    StubClient* client = FromHandle<StubClient>(handle, err);
+    if (client == nullptr) {
+        return 0;
+    }
+    counters.requests++;
+    StubConfig config = ConfigForRequest(client->config, request, requestLength);
+
+    double latencyMs = config.latencyMs + config.latencyJitterMs * RandomUnit();
+    if (++client->inFlight > client->concurrentRequestsTarget) {
+        latencyMs += config.creditLatencyMs;
+    }
+    SleepMs(latencyMs);
+    client->inFlight--;
+    if (config.errorRate > 0 && RandomUnit() < config.errorRate) {
+        SetError(err, config.error);
+        return 0;
+    }
+    client->creditsSpent += kCreditAmountPerRequest;
+
+    StubResponse* response = new StubResponse();
+    response->config = config;
+    response->streaming = config.stream > 0;
+    response->metadata = Metadata(config, response->streaming);
+    if (!response->streaming) {
+        response->body = Body(config);
+    }
+    return NewHandle(response);
+}
+
+void Confsec_ResponseDestroy(uintptr_t handle, char** err) {
+    DestroyHandle<StubResponse>(handle, err);
+}
+
+char* Confsec_ResponseGetMetadata(uintptr_t handle, char** err) {
+    StubResponse* response = FromHandle<StubResponse>(handle, err);
+    return response ? Dup(response->metadata) : nullptr;
+}
+
+bool Confsec_ResponseIsStreaming(uintptr_t handle, char** err) {
+    StubResponse* response = FromHandle<StubResponse>(handle, err);
+    return response ? response->streaming : false;
+}
+
+char* Confsec_ResponseGetBody(uintptr_t handle, char** err) {
+    StubResponse* response = FromHandle<StubResponse>(handle, err);
+    return response ? Dup(response->body) : nullptr;
+}
+
+uintptr_t Confsec_ResponseGetStream(uintptr_t handle, char** err) {
+    StubResponse* response = FromHandle<StubResponse>(handle, err);
+    if (response == nullptr) {
+        return 0;
+    }
+    if (!response->streaming) {
+        SetError(err, "response is not streaming");
+        return 0;
+    }
+    StubStream* stream = new StubStream();
+    stream->config = response->config;
+    return NewHandle(stream);
+}
+
+char* Confsec_ResponseStreamGetNext(uintptr_t handle, char** err) {
+    StubStream* stream = FromHandle<StubStream>(handle, err);
+    if (stream == nullptr) {
+        return nullptr;
+    }
+    const StubConfig& config = stream->config;
+    // SSE streams end with a [DONE] event after the content chunks
+    size_t total = config.chunks + (config.sse ? 1 : 0);
+    if (stream->next >= total) {
+        return nullptr;
+    }
+
+    SleepMs(config.chunkIntervalUs / 1000);
+    if (config.streamErrorAt >= 0 && stream->next == static_cast<size_t>(config.streamErrorAt)) {
+        SetError(err, "connection reset by peer");
+        return nullptr;
+    }
+
+    counters.chunks++;
+    bool done = stream->next++ == config.chunks;
+    return Dup(done ? "data: [DONE]\n\n" : Chunk(config));
+}
+
+void Confsec_ResponseStreamDestroy(uintptr_t handle, char** err) {
+    DestroyHandle<StubStream>(handle, err);
+}
+
+void Confsec_Free(void* ptr) {
+    if (ptr != nullptr) {
+        counters.frees++;
+        free(ptr);
+    }
+}
+
+void ConfsecStub_GetStats(ConfsecStub_Stats* stats) {
+    stats->requests = counters.requests;
+    stats->errors = counters.errors;
+    stats->chunks = counters.chunks;
+    stats->allocations = counters.allocations;
+    stats->frees = counters.frees;
+    stats->bytesAllocated = counters.bytesAllocated;
+    stats->liveHandles = counters.liveHandles;
+}
+
+void ConfsecStub_ResetStats(void) {
+    counters.requests = 0;
+    counters.errors = 0;
+    counters.chunks = 0;
+    counters.allocations = 0;
+    counters.frees = 0;
+    counters.bytesAllocated = 0;
+}
+
+} // extern "C"
@@ -204,6 +204,11 @@ if (require.main === module) {
     process.exit(0);
   }
 
+  if (process.env.LIBCONFSEC_STUB === 'true') {
+    console.log('Using stub libconfsec (LIBCONFSEC_STUB=true)');
+    process.exit(0);
+  }
+
   if (process.env.SKIP_LIBCONFSEC_DOWNLOAD === 'true') {
     console.log('Skipping libconfsec download (SKIP_LIBCONFSEC_DOWNLOAD=true)');
     process.exit(0);
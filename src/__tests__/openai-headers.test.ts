@@ -0,0 +1,70 @@
+import { OpenAI } from '../openai';
+import { StaticHeaders } from '../libconfsec/headers';
+import { MockLibconfsec } from '../libconfsec/__tests__/utils/mocks';
+
+const API_URL = 'https://api.openpcc-example.com';
+
+function headerLines(request: string): string[] {
+  return request.split('\r\n\r\n')[0].split('\r\n').slice(1);
+}
+
+function headerNames(request: string): string[] {
+  return headerLines(request).map(line => line.split(':')[0]);
+}
+
+describe('OpenAI wrapper static headers', () => {
+  test('headers the wrapper sends are written once', async () => {
+    const lc = new MockLibconfsec();
+    const openAI = new OpenAI({
+      apiKey: 'test',
+      confsecConfig: { apiUrl: API_URL, libconfsec: lc },
+    });
+    lc.confsecResponseGetMetadata.mockReturnValue(
+      Buffer.from(
+        JSON.stringify({
+          status_code: 200,
+          reason_phrase: 'OK',
+          http_version: 'HTTP/1.1',
+          url: '',
+          headers: [{ key: 'content-type', value: 'application/json' }],
+        })
+      )
+    );
+    lc.confsecResponseIsStreaming.mockReturnValue(false);
+    lc.confsecResponseGetBody.mockReturnValue(
+      Buffer.from(JSON.stringify({ object: 'text_completion', choices: [] }))
+    );
+    // Request buffers are reused, so they are read as they are sent
+    const requests: string[] = [];
+    lc.confsecClientDoRequest.mockImplementation((_, request) => {
+      requests.push(request.toString());
+      return 1;
+    });
+    const create = () => openAI.completions.create({ model: 'm', prompt: 'p' });
+
+    await create();
+    // Make every header the wrapper sent static, less those set per request
+    const lines = headerLines(requests[0]).filter(
+      line => !/^(host|content-length):/.test(line)
+    );
+    openAI.confsecClient.setStaticHeaders(
+      Object.fromEntries(
+        lines.map(line => {
+          const colon = line.indexOf(': ');
+          return [line.slice(0, colon), line.slice(colon + 2)];
+        })
+      )
+    );
+    const encode = jest.spyOn(StaticHeaders.prototype, 'encode');
+    await create();
+    await create();
+
+    // The encoded block is reused even though the wrapper sets every header
+    expect(encode.mock.results[1].value).toBe(encode.mock.results[0].value);
+    const sent = headerNames(requests[1]);
+    expect(new Set(sent).size).toEqual(sent.length);
+    expect(sent.sort()).toEqual(headerNames(requests[0]).sort());
+    encode.mockRestore();
+    openAI.close();
+  });
+});
@@ -1,5 +1,6 @@
 export abstract class Closeable {
   private closed: boolean;
+  private closeListeners: (() => void)[] = [];
 
   constructor() {
     this.closed = false;
@@ -7,9 +8,31 @@ export abstract class Closeable {
 
   protected abstract doClose(): void;
 
+  get isClosed(): boolean {
+    return this.closed;
+  }
+
+  /**
+   * Register a listener to run once the object has been closed. Listeners
+   * run even if freeing the underlying resources fails.
+   */
+  public onClose(listener: () => void) {
+    if (this.closed) {
+      listener();
+      return;
+    }
+    this.closeListeners.push(listener);
+  }
+
   public close() {
     if (this.closed) return;
-    this.doClose();
-    this.closed = true;
+    try {
+      this.doClose();
+      this.closed = true;
+    } finally {
+      const listeners = this.closeListeners;
+      this.closeListeners = [];
+      listeners.forEach(listener => listener());
+    }
   }
 }
@@ -2,12 +2,51 @@ export {
   ConfsecClient,
   ConfsecResponse,
   ConfsecResponseStream,
+  ConfsecOverloadError,
+  DIAGNOSTICS_CHANNELS,
+  getErrorCode,
+  isTransientError,
+  NodeTagSet,
 } from './libconfsec';
 
 export type {
+  ChromeTrace,
+  ChunkTiming,
   ConfsecClientConfig,
+  ConfsecErrorCode,
+  ConfsecNativeError,
+  ConfsecRequestInit,
+  HandleTrackingConfig,
+  HedgingConfig,
+  HedgingStats,
+  HistogramSnapshot,
   IdentityPolicySource,
+  LatencyHistogramsConfig,
+  LiveHandle,
+  ModelLatencySnapshot,
+  NativeCallStats,
+  NativeSpan,
+  NativeStats,
+  NativeTrace,
+  OverloadReason,
+  RequestBufferPoolConfig,
+  RequestBufferPoolStats,
+  RequestChunkMessage,
+  RequestEndMessage,
+  RequestErrorMessage,
+  RequestHeadersMessage,
+  RequestStartMessage,
+  ResponseCacheConfig,
+  ResponseCacheStats,
   ResponseMetadata,
+  ResponseSource,
+  ResponseTimings,
+  RetryConfig,
+  RetryStats,
+  SlowCallHook,
+  StreamChunk,
+  TraceEvent,
+  TracingConfig,
   WalletStatus,
 } from './libconfsec';
 
@@ -0,0 +1,75 @@
+import { BufferLease, RequestBufferPool } from '../bufferpool';
+
+describe('RequestBufferPool', () => {
+  test('reuses released buffers of the same size class', () => {
+    const pool = new RequestBufferPool();
+    const first = pool.acquire(100);
+    expect(first.length).toBe(1024);
+    pool.release(first.subarray(0, 100));
+    expect(pool.stats).toEqual({
+      reused: 0,
+      allocated: 1,
+      inUse: 0,
+      idleBytes: 1024,
+    });
+
+    const second = pool.acquire(1000);
+    expect(second.buffer).toBe(first.buffer);
+    const third = pool.acquire(1500);
+    expect(third.length).toBe(2048);
+    expect(pool.stats).toEqual({
+      reused: 1,
+      allocated: 2,
+      inUse: 2,
+      idleBytes: 0,
+    });
+  });
+
+  test('keeps idle buffers up to maxBytes', () => {
+    const pool = new RequestBufferPool({ maxBytes: 2048 });
+    const buffers = [pool.acquire(1), pool.acquire(1), pool.acquire(1)];
+    buffers.forEach(buffer => pool.release(buffer));
+    expect(pool.stats).toMatchObject({ inUse: 0, idleBytes: 2048 });
+    pool.clear();
+    expect(pool.stats.idleBytes).toBe(0);
+  });
+
+  test('does not pool buffers larger than maxBufferBytes', () => {
+    const pool = new RequestBufferPool({ maxBufferBytes: 4096 });
+    const buffer = pool.acquire(5000);
+    expect(buffer.length).toBe(5000);
+    expect(pool.stats.inUse).toBe(0);
+    pool.release(buffer);
+    expect(pool.stats.idleBytes).toBe(0);
+  });
+
+  test('ignores buffers it did not hand out', () => {
+    const pool = new RequestBufferPool();
+    const buffer = pool.acquire(10);
+    pool.release(Buffer.allocUnsafeSlow(1024));
+    pool.release(buffer);
+    pool.release(buffer);
+    expect(pool.stats).toMatchObject({ inUse: 0, idleBytes: 1024 });
+  });
+});
+
+describe('BufferLease', () => {
+  test('releases the buffer once ended and every attempt settled', async () => {
+    const pool = new RequestBufferPool();
+    const lease = new BufferLease(pool, pool.acquire(10));
+    let resolve!: () => void;
+    let reject!: (error: Error) => void;
+    const first = lease.track(new Promise<void>(r => (resolve = r)));
+    const second = lease
+      .track(new Promise<void>((_, r) => (reject = r)))
+      .catch(() => undefined);
+
+    lease.end();
+    resolve();
+    await first;
+    expect(pool.stats.inUse).toBe(1);
+    reject(new Error('lost'));
+    await second;
+    expect(pool.stats.inUse).toBe(0);
+  });
+});
@@ -0,0 +1,75 @@
+import { ResponseCache } from '../cache';
+
+const HEADERS = [{ key: 'content-type', value: 'application/json' }];
+
+function body(text: string): Uint8Array[] {
+  return [Buffer.from(text)];
+}
+
+describe('ResponseCache', () => {
+  afterEach(() => {
+    jest.useRealTimers();
+  });
+
+  test('returns cached responses and counts hits and misses', async () => {
+    const cache = new ResponseCache();
+    expect(cache.get('key')).toBeNull();
+    cache.set('key', 200, 'OK', HEADERS, [
+      Buffer.from('{"a":'),
+      Buffer.from('1}'),
+    ]);
+
+    const cached = cache.get('key');
+    expect(cached?.body).toEqual(Buffer.from('{"a":1}'));
+    const response = cached!.toResponse();
+    expect(response.status).toEqual(200);
+    expect(response.headers.get('content-type')).toEqual('application/json');
+    expect(await response.json()).toEqual({ a: 1 });
+
+    expect(cache.stats).toMatchObject({ hits: 1, misses: 1, entries: 1 });
+  });
+
+  test('expires entries after the TTL', () => {
+    jest.useFakeTimers();
+    const cache = new ResponseCache({ ttlMs: 1000 });
+    cache.set('key', 200, 'OK', HEADERS, body('x'));
+    jest.advanceTimersByTime(999);
+    expect(cache.get('key')).not.toBeNull();
+    jest.advanceTimersByTime(1);
+    expect(cache.get('key')).toBeNull();
+    expect(cache.stats).toMatchObject({ expirations: 1, entries: 0, bytes: 0 });
+  });
+
+  test('evicts least recently used entries', () => {
+    const cache = new ResponseCache({ maxEntries: 2 });
+    cache.set('a', 200, 'OK', HEADERS, body('a'));
+    cache.set('b', 200, 'OK', HEADERS, body('b'));
+    cache.get('a');
+    cache.set('c', 200, 'OK', HEADERS, body('c'));
+
+    expect(cache.get('a')).not.toBeNull();
+    expect(cache.get('b')).toBeNull();
+    expect(cache.get('c')).not.toBeNull();
+    expect(cache.stats.evictions).toEqual(1);
+  });
+
+  test('bounds the total size in bytes', () => {
+    const cache = new ResponseCache({ maxBytes: 4096 });
+    cache.set('a', 200, 'OK', HEADERS, body('a'.repeat(2000)));
+    cache.set('b', 200, 'OK', HEADERS, body('b'.repeat(2000)));
+    expect(cache.stats.entries).toEqual(1);
+    expect(cache.stats.bytes).toBeLessThanOrEqual(4096);
+
+    cache.set('big', 200, 'OK', HEADERS, body('c'.repeat(8192)));
+    expect(cache.get('big')).toBeNull();
+    expect(cache.get('b')).not.toBeNull();
+  });
+
+  test('clear drops all entries', () => {
+    const cache = new ResponseCache();
+    cache.set('a', 200, 'OK', HEADERS, body('a'));
+    cache.clear();
+    expect(cache.get('a')).toBeNull();
+    expect(cache.stats).toMatchObject({ entries: 0, bytes: 0 });
+  });
+});
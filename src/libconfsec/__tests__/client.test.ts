@@ -83,6 +83,205 @@ describe('Wallet status', () => {
       client.handle
     );
   });
+
+  test('credits are fetched without a background refresh', () => {
+    const mockLibconfsec = new MockLibconfsec();
+    mockLibconfsec.confsecClientGetWalletStatus.mockReturnValue(
+      JSON.stringify({
+        credits_spent: 1,
+        credits_held: 2,
+        credits_available: 3,
+      })
+    );
+    const client = new ConfsecClient({
+      apiUrl: API_URL,
+      apiKey: 'my-api-key',
+      libconfsec: mockLibconfsec,
+    });
+    expect(client.creditsAvailable).toEqual(3);
+    expect(client.creditsHeld).toEqual(2);
+    expect(
+      mockLibconfsec.confsecClientStartWalletRefresh
+    ).not.toHaveBeenCalled();
+  });
+
+  test('credits are read from the background-refreshed snapshot', async () => {
+    const mockLibconfsec = new MockLibconfsec();
+    let refreshed: number[] | null = null;
+    mockLibconfsec.confsecClientReadWallet.mockImplementation(
+      (_: number, status: Float64Array) => {
+        if (refreshed !== null) {
+          status.set(refreshed);
+        }
+        return refreshed !== null;
+      }
+    );
+    mockLibconfsec.confsecClientGetWalletStatus.mockReturnValue(
+      JSON.stringify({
+        credits_spent: 0,
+        credits_held: 0,
+        credits_available: 40,
+      })
+    );
+    let stopped!: () => void;
+    mockLibconfsec.confsecClientStopWalletRefresh.mockReturnValue(
+      new Promise<void>(resolve => (stopped = resolve))
+    );
+    const client = new ConfsecClient({
+      apiUrl: API_URL,
+      apiKey: 'my-api-key',
+      walletRefreshMs: 500,
+      libconfsec: mockLibconfsec,
+    });
+    expect(
+      mockLibconfsec.confsecClientStartWalletRefresh
+    ).toHaveBeenCalledWith(client.handle, 500);
+
+    // Fetched until the first refresh has completed
+    expect(client.creditsAvailable).toEqual(40);
+    refreshed = [30, 20, 10];
+    expect(client.creditsAvailable).toEqual(30);
+    expect(client.creditsHeld).toEqual(20);
+    refreshed = [25, 0, 15];
+    expect(client.creditsAvailable).toEqual(25);
+    expect(
+      mockLibconfsec.confsecClientGetWalletStatus
+    ).toHaveBeenCalledTimes(1);
+
+    // The client is destroyed once the refresh thread has stopped
+    client.close();
+    expect(
+      mockLibconfsec.confsecClientStopWalletRefresh
+    ).toHaveBeenCalledWith(client.handle);
+    expect(mockLibconfsec.confsecClientDestroy).not.toHaveBeenCalled();
+    stopped();
+    await new Promise(resolve => setImmediate(resolve));
+    expect(mockLibconfsec.confsecClientDestroy).toHaveBeenCalledWith(
+      client.handle
+    );
+  });
+});
+
+describe('Node tags', () => {
+  test('default node tags are fetched again only once changed', () => {
+    const mockLibconfsec = new MockLibconfsec();
+    mockLibconfsec.confsecClientGetDefaultNodeTags
+      .mockReturnValueOnce(['model=a'])
+      .mockReturnValueOnce(['model=b']);
+    const client = new ConfsecClient({
+      apiUrl: API_URL,
+      apiKey: 'my-api-key',
+      libconfsec: mockLibconfsec,
+    });
+    expect(client.getDefaultNodeTags()).toEqual(['model=a']);
+    client.getDefaultNodeTags().push('pool=x');
+    expect(client.getDefaultNodeTags()).toEqual(['model=a']);
+    expect(
+      mockLibconfsec.confsecClientGetDefaultNodeTags
+    ).toHaveBeenCalledTimes(1);
+
+    client.setDefaultNodeTags(['model=b']);
+    expect(client.getDefaultNodeTags()).toEqual(['model=b']);
+    expect(
+      mockLibconfsec.confsecClientGetDefaultNodeTags
+    ).toHaveBeenCalledTimes(2);
+  });
+
+  test('node tag sets are passed to the binding as created', () => {
+    const mockLibconfsec = new MockLibconfsec();
+    const native = { tagSet: 1 };
+    mockLibconfsec.confsecNodeTagSetCreate.mockReturnValue(native);
+    mockLibconfsec.confsecClientDoRequest.mockReturnValue(2);
+    const client = new ConfsecClient({
+      apiUrl: API_URL,
+      apiKey: 'my-api-key',
+      libconfsec: mockLibconfsec,
+    });
+    const tags = ['model=a', 'region=eu'];
+    const tagSet = client.createNodeTagSet(tags);
+    tags.push('pool=x');
+    expect(tagSet.tags).toEqual(['model=a', 'region=eu']);
+    expect(mockLibconfsec.confsecNodeTagSetCreate).toHaveBeenCalledTimes(1);
+
+    client.setDefaultNodeTags(tagSet);
+    expect(
+      mockLibconfsec.confsecClientSetDefaultNodeTags
+    ).toHaveBeenCalledWith(client.handle, native);
+    client.doRequest('GET / HTTP/1.1\r\n\r\n', tagSet);
+    expect(mockLibconfsec.confsecClientDoRequest).toHaveBeenCalledWith(
+      client.handle,
+      'GET / HTTP/1.1\r\n\r\n',
+      native
+    );
+  });
+});
+
+describe('Native stats', () => {
+  test('getStats returns the binding counters', () => {
+    const mockLibconfsec = new MockLibconfsec();
+    const stats = {
+      liveClients: 1,
+      inFlightRequests: 2,
+      liveResponses: 3,
+      openStreams: 1,
+      nativeBytesOutstanding: 512,
+      requests: 10,
+      chunks: 40,
+      bytesDelivered: 8000,
+      errors: { CONFSEC_NO_NODES: 1 },
+    };
+    mockLibconfsec.confsecGetStats.mockReturnValue(stats);
+    const client = new ConfsecClient({
+      apiUrl: API_URL,
+      apiKey: 'my-api-key',
+      libconfsec: mockLibconfsec,
+    });
+    expect(client.getStats()).toEqual(stats);
+  });
+
+  test('getNativeCallStats returns the binding call stats', () => {
+    const mockLibconfsec = new MockLibconfsec();
+    const stats = {
+      confsecClientDoRequest: {
+        calls: 2,
+        totalMs: 3,
+        maxMs: 2,
+        buckets: [0, 0, 1, 1],
+      },
+    };
+    mockLibconfsec.confsecGetCallStats.mockReturnValue(stats);
+    const client = new ConfsecClient({
+      apiUrl: API_URL,
+      apiKey: 'my-api-key',
+      libconfsec: mockLibconfsec,
+    });
+    expect(client.getNativeCallStats()).toEqual(stats);
+    client.resetNativeCallStats();
+    expect(mockLibconfsec.confsecResetCallStats).toHaveBeenCalled();
+  });
+
+  test('setSlowCallHook sets and removes the binding hook', () => {
+    const mockLibconfsec = new MockLibconfsec();
+    const client = new ConfsecClient({
+      apiUrl: API_URL,
+      apiKey: 'my-api-key',
+      libconfsec: mockLibconfsec,
+    });
+    const hook = jest.fn();
+    client.setSlowCallHook(10, hook);
+    expect(mockLibconfsec.confsecSetSlowCallHook).toHaveBeenCalledWith(
+      10,
+      hook
+    );
+    client.setSlowCallHook(0, null);
+    expect(mockLibconfsec.confsecSetSlowCallHook).toHaveBeenLastCalledWith(
+      0,
+      null
+    );
+    expect(() => client.setSlowCallHook(0, hook)).toThrow(
+      'thresholdMs must be positive'
+    );
+  });
 });
 
 describe('Resource Management', () => {
@@ -1,5 +1,6 @@
 import { MockLibconfsec } from './utils/mocks';
 import * as client from '../client';
+import { StaticHeaders } from '../headers';
 
 const API_URL = 'https://api.openpcc-example.com';
 const BASE_URL = 'https://confsec.invalid';
@@ -82,6 +83,15 @@ describe('Request Preprocessing', () => {
     );
   });
 
+  test('getModelTag reads the header before per-request tags', () => {
+    const request = new Request(url('/v1/completions'), {
+      headers: { 'x-confsec-node-tags': 'foo=bar,model=a' },
+    });
+    expect(client.getModelTag(request, ['model=b'])).toEqual('a');
+    expect(client.getModelTag(new Request(url('/')), ['model=b'])).toEqual('b');
+    expect(client.getModelTag(new Request(url('/')))).toBeNull();
+  });
+
   test('maybeAddModelTag with null body', () => {
     const request = new Request(url('/v1/completions'));
     client.maybeAddModelTag(request, null);
@@ -129,6 +139,53 @@ describe('Request Encoding', () => {
     expect(rawRequest).toContain('x-confsec-node-tags: foo=bar\r\n');
     expect(rawRequest).toMatch(/\r\n\r\n$/);
   });
+
+  test('prepareRequest copies the static header block', () => {
+    const body = encoder.encode('{}').buffer;
+    const staticHeaders = new StaticHeaders({ 'user-agent': 'test/1.0' });
+    const request = new Request(url('/v1/completions'), {
+      method: 'POST',
+      headers: { 'content-type': 'application/json' },
+      body,
+    });
+    const rawRequest = client.prepareRequest(
+      request,
+      body,
+      undefined,
+      staticHeaders
+    );
+
+    expect(rawRequest.toString()).toEqual(
+      'POST /v1/completions HTTP/1.1\r\n' +
+        'host: confsec.invalid\r\n' +
+        'user-agent: test/1.0\r\n' +
+        'content-type: application/json\r\n' +
+        'content-length: 2\r\n\r\n{}'
+    );
+  });
+
+  test('prepareRequest writes static headers set on the request once', () => {
+    const staticHeaders = new StaticHeaders({
+      'user-agent': 'test/1.0',
+      accept: 'application/json',
+    });
+    const request = new Request(url('/v1/models'), {
+      headers: { 'user-agent': 'test/1.0', accept: '*/*' },
+    });
+    const rawRequest = client.prepareRequest(
+      request,
+      null,
+      undefined,
+      staticHeaders
+    );
+
+    expect(rawRequest.toString()).toEqual(
+      'GET /v1/models HTTP/1.1\r\n' +
+        'host: confsec.invalid\r\n' +
+        'user-agent: test/1.0\r\n' +
+        'accept: */*\r\n\r\n'
+    );
+  });
 });
 
 describe('CONFSEC fetch', () => {
@@ -218,4 +275,697 @@ describe('CONFSEC fetch', () => {
     expect(lc.confsecResponseStreamDestroy).toHaveBeenCalledTimes(1);
     expect(lc.confsecResponseDestroy).toHaveBeenCalledTimes(1);
   });
+
+  test('confsecFetch passes per-request node tags', async () => {
+    lc.confsecResponseGetMetadata.mockReturnValue(
+      Buffer.from(
+        JSON.stringify({
+          status_code: 200,
+          reason_phrase: 'OK',
+          http_version: 'HTTP/1.1',
+          url: '',
+          headers: [],
+        })
+      )
+    );
+    lc.confsecResponseIsStreaming.mockReturnValue(false);
+    lc.confsecResponseGetBody.mockReturnValue(Buffer.from('{}'));
+
+    const init: client.ConfsecRequestInit = {
+      method: 'POST',
+      body: '{}',
+      nodeTags: ['pool=batch'],
+    };
+    const response = await cc.getConfsecFetch()(url('/v1/completions'), init);
+    await response.text();
+
+    const [handle, rawRequest, nodeTags] =
+      lc.confsecClientDoRequest.mock.calls[0];
+    expect(handle).toEqual(cc.handle);
+    expect(nodeTags).toEqual(['pool=batch']);
+    expect(rawRequest.toString()).not.toContain('x-confsec-node-tags');
+  });
+
+  test('confsecFetch reports timings in a header', async () => {
+    lc.confsecResponseGetMetadata.mockReturnValue(
+      Buffer.from(
+        JSON.stringify({
+          status_code: 200,
+          reason_phrase: 'OK',
+          http_version: 'HTTP/1.1',
+          url: '',
+          headers: [],
+        })
+      )
+    );
+    lc.confsecResponseIsStreaming.mockReturnValue(true);
+    lc.confsecResponseGetStream.mockReturnValue(1);
+    lc.confsecResponseStreamGetNext.mockReturnValue(null);
+
+    const confsecFetch = cc.getConfsecFetch();
+    const response = await confsecFetch(url('/v1/completions'), {
+      method: 'POST',
+      body: JSON.stringify({ test: 'data' }),
+    });
+
+    const timings = response.headers.get('x-confsec-timings');
+    expect(timings).toMatch(
+      /^serialized=[\d.]+, submitted=[\d.]+, headersReceived=[\d.]+$/
+    );
+    await response.text();
+  });
+
+  test('confsecFetch reads streams on the thread pool', async () => {
+    const asyncClient = new client.ConfsecClient({
+      apiUrl: API_URL,
+      apiKey: 'test',
+      asyncStreamReads: true,
+      libconfsec: lc,
+    });
+    lc.confsecResponseGetMetadata.mockReturnValue(
+      Buffer.from(
+        JSON.stringify({
+          status_code: 200,
+          reason_phrase: 'OK',
+          http_version: 'HTTP/1.1',
+          url: '',
+          headers: [],
+        })
+      )
+    );
+    lc.confsecResponseIsStreaming.mockReturnValue(true);
+    lc.confsecResponseGetStream.mockReturnValue(1);
+    lc.confsecResponseStreamGetNextAsync
+      .mockResolvedValueOnce({ chunk: Buffer.from('a'), delayMs: 1 })
+      .mockResolvedValueOnce({ chunk: Buffer.from('b'), delayMs: 1 })
+      .mockResolvedValueOnce({ chunk: null, delayMs: 0 });
+
+    const response = await asyncClient.getConfsecFetch()(
+      url('/v1/completions'),
+      { method: 'POST', body: JSON.stringify({ test: 'data' }) }
+    );
+
+    expect(await response.text()).toEqual('ab');
+    expect(lc.confsecResponseStreamGetNext).not.toHaveBeenCalled();
+    expect(lc.confsecResponseStreamGetNextAsync).toHaveBeenCalledTimes(3);
+    expect(lc.confsecResponseStreamDestroy).toHaveBeenCalledTimes(1);
+    expect(lc.confsecResponseDestroy).toHaveBeenCalledTimes(1);
+  });
+
+  test('closed responses refresh the wallet snapshot', async () => {
+    lc.confsecClientStopWalletRefresh.mockResolvedValue(undefined);
+    const refreshedClient = new client.ConfsecClient({
+      apiUrl: API_URL,
+      apiKey: 'test',
+      walletRefreshMs: 60000,
+      libconfsec: lc,
+    });
+    lc.confsecResponseGetMetadata.mockReturnValue(
+      Buffer.from(
+        JSON.stringify({
+          status_code: 200,
+          reason_phrase: 'OK',
+          http_version: 'HTTP/1.1',
+          url: '',
+          headers: [],
+        })
+      )
+    );
+    lc.confsecResponseIsStreaming.mockReturnValue(false);
+    lc.confsecResponseGetBody.mockReturnValue(Buffer.from('{}'));
+
+    const response = await refreshedClient.getConfsecFetch()(
+      url('/v1/completions'),
+      { method: 'POST', body: '{}' }
+    );
+    await response.text();
+    expect(lc.confsecClientRefreshWallet).toHaveBeenCalledWith(
+      refreshedClient.handle
+    );
+  });
+});
+
+describe('CONFSEC fetch load shedding', () => {
+  let lc: MockLibconfsec;
+  let cc: client.ConfsecClient;
+
+  beforeEach(() => {
+    lc = new MockLibconfsec();
+    cc = new client.ConfsecClient({
+      apiUrl: API_URL,
+      apiKey: 'test',
+      maxConcurrentRequests: 1,
+      maxQueueDepth: 0,
+      libconfsec: lc,
+    });
+    lc.confsecResponseGetMetadata.mockReturnValue(
+      Buffer.from(
+        JSON.stringify({
+          status_code: 200,
+          reason_phrase: 'OK',
+          http_version: 'HTTP/1.1',
+          url: '',
+          headers: [],
+        })
+      )
+    );
+    lc.confsecResponseIsStreaming.mockReturnValue(true);
+    lc.confsecResponseGetStream.mockReturnValue(1);
+    lc.confsecResponseStreamGetNext
+      .mockReturnValueOnce(Buffer.from('data'))
+      .mockReturnValueOnce(null);
+  });
+
+  afterEach(() => {
+    lc.reset();
+  });
+
+  test('open streams hold a slot until consumed', async () => {
+    const confsecFetch = cc.getConfsecFetch();
+    const response = await confsecFetch(url('/v1/completions'), {
+      method: 'POST',
+      body: '{}',
+    });
+    expect(cc.getInFlightRequests()).toEqual(1);
+
+    await expect(
+      confsecFetch(url('/v1/completions'), { method: 'POST', body: '{}' })
+    ).rejects.toMatchObject({ code: 'CONFSEC_OVERLOADED' });
+    expect(lc.confsecClientDoRequest).toHaveBeenCalledTimes(1);
+
+    await response.text();
+    expect(cc.getInFlightRequests()).toEqual(0);
+  });
+
+  test('failed requests release their slot', async () => {
+    lc.confsecClientDoRequest.mockImplementationOnce(() => {
+      throw new Error('boom');
+    });
+    const confsecFetch = cc.getConfsecFetch();
+    await expect(
+      confsecFetch(url('/v1/completions'), { method: 'POST', body: '{}' })
+    ).rejects.toThrow('boom');
+    expect(cc.getInFlightRequests()).toEqual(0);
+  });
+});
+
+describe('CONFSEC fetch retries', () => {
+  test('transient failures are retried', async () => {
+    const lc = new MockLibconfsec();
+    const cc = new client.ConfsecClient({
+      apiUrl: API_URL,
+      apiKey: 'test',
+      retry: { baseDelayMs: 0, maxRetryRatio: 1 },
+      libconfsec: lc,
+    });
+    lc.confsecClientDoRequest
+      .mockImplementationOnce(() => {
+        throw Object.assign(new Error('no nodes available'), {
+          code: 'CONFSEC_NO_NODES',
+          transient: true,
+        });
+      })
+      .mockReturnValueOnce(1);
+    lc.confsecResponseGetMetadata.mockReturnValue(
+      Buffer.from(
+        JSON.stringify({
+          status_code: 200,
+          reason_phrase: 'OK',
+          http_version: 'HTTP/1.1',
+          url: '',
+          headers: [],
+        })
+      )
+    );
+    lc.confsecResponseIsStreaming.mockReturnValue(false);
+    lc.confsecResponseGetBody.mockReturnValue(Buffer.from('ok'));
+
+    const response = await cc.getConfsecFetch()(url('/v1/completions'), {
+      method: 'POST',
+      body: '{}',
+    });
+    expect(await response.text()).toEqual('ok');
+    expect(lc.confsecClientDoRequest).toHaveBeenCalledTimes(2);
+    expect(cc.getRetryStats()).toMatchObject({ retries: 1, recovered: 1 });
+  });
+
+  test('retries can be disabled', async () => {
+    const lc = new MockLibconfsec();
+    const cc = new client.ConfsecClient({
+      apiUrl: API_URL,
+      apiKey: 'test',
+      retry: false,
+      libconfsec: lc,
+    });
+    lc.confsecClientDoRequest.mockImplementation(() => {
+      throw Object.assign(new Error('no nodes available'), {
+        code: 'CONFSEC_NO_NODES',
+        transient: true,
+      });
+    });
+    await expect(
+      cc.getConfsecFetch()(url('/v1/completions'), { method: 'POST' })
+    ).rejects.toMatchObject({ code: 'CONFSEC_NO_NODES' });
+    expect(lc.confsecClientDoRequest).toHaveBeenCalledTimes(1);
+    expect(cc.getRetryStats()).toBeNull();
+  });
+
+  test('retries are disabled by default', async () => {
+    const lc = new MockLibconfsec();
+    const cc = new client.ConfsecClient({
+      apiUrl: API_URL,
+      apiKey: 'test',
+      libconfsec: lc,
+    });
+    lc.confsecClientDoRequest.mockImplementation(() => {
+      throw Object.assign(new Error('no nodes available'), {
+        code: 'CONFSEC_NO_NODES',
+        transient: true,
+      });
+    });
+    await expect(
+      cc.getConfsecFetch()(url('/v1/completions'), { method: 'POST' })
+    ).rejects.toMatchObject({ code: 'CONFSEC_NO_NODES' });
+    expect(lc.confsecClientDoRequest).toHaveBeenCalledTimes(1);
+    expect(cc.getRetryStats()).toBeNull();
+  });
+});
+
+describe('CONFSEC fetch request coalescing', () => {
+  let lc: MockLibconfsec;
+  let cc: client.ConfsecClient;
+
+  beforeEach(() => {
+    lc = new MockLibconfsec();
+    cc = new client.ConfsecClient({
+      apiUrl: API_URL,
+      apiKey: 'test',
+      coalesceRequests: true,
+      libconfsec: lc,
+    });
+    lc.confsecResponseGetMetadata.mockReturnValue(
+      Buffer.from(
+        JSON.stringify({
+          status_code: 200,
+          reason_phrase: 'OK',
+          http_version: 'HTTP/1.1',
+          url: '',
+          headers: [{ key: 'content-type', value: 'application/json' }],
+        })
+      )
+    );
+  });
+
+  afterEach(() => {
+    lc.reset();
+  });
+
+  function completion(prompt: string, nodeTags?: string[]): Promise<Response> {
+    const init: client.ConfsecRequestInit = {
+      method: 'POST',
+      body: JSON.stringify({ model: 'm', prompt, temperature: 0 }),
+    };
+    if (nodeTags) {
+      init.nodeTags = nodeTags;
+    }
+    return cc.getConfsecFetch()(url('/v1/completions'), init);
+  }
+
+  test('identical concurrent requests share one response', async () => {
+    lc.confsecResponseIsStreaming.mockReturnValue(false);
+    lc.confsecResponseGetBody.mockReturnValue(Buffer.from('{"test": 1}'));
+
+    const responses = await Promise.all([completion('a'), completion('a')]);
+
+    expect(lc.confsecClientDoRequest).toHaveBeenCalledTimes(1);
+    expect(lc.confsecResponseDestroy).toHaveBeenCalledTimes(1);
+    expect(cc.getCoalescedRequests()).toEqual(1);
+    for (const response of responses) {
+      expect(response.status).toEqual(200);
+      expect(response.headers.get('content-type')).toEqual('application/json');
+      expect(await response.json()).toEqual({ test: 1 });
+    }
+  });
+
+  test('followers receive the whole leader stream', async () => {
+    lc.confsecResponseIsStreaming.mockReturnValue(true);
+    lc.confsecResponseGetStream.mockReturnValue(1);
+    lc.confsecResponseStreamGetNext
+      .mockReturnValueOnce(Buffer.from('foo,'))
+      .mockReturnValueOnce(Buffer.from('bar'))
+      .mockReturnValueOnce(null);
+
+    const [leader, follower] = await Promise.all([
+      completion('a'),
+      completion('a'),
+    ]);
+    expect(await leader.text()).toEqual('foo,bar');
+    expect(await follower.text()).toEqual('foo,bar');
+    expect(lc.confsecClientDoRequest).toHaveBeenCalledTimes(1);
+    expect(lc.confsecResponseStreamDestroy).toHaveBeenCalledTimes(1);
+  });
+
+  test('different requests are not coalesced', async () => {
+    lc.confsecResponseIsStreaming.mockReturnValue(false);
+    lc.confsecResponseGetBody.mockReturnValue(Buffer.from('{}'));
+
+    await Promise.all([completion('a'), completion('b')]);
+    expect(lc.confsecClientDoRequest).toHaveBeenCalledTimes(2);
+    expect(cc.getCoalescedRequests()).toEqual(0);
+  });
+
+  test('requests with different node tags are not coalesced', async () => {
+    lc.confsecResponseIsStreaming.mockReturnValue(false);
+    lc.confsecResponseGetBody.mockReturnValue(Buffer.from('{}'));
+
+    await Promise.all([
+      completion('a', ['pool=a']),
+      completion('a', ['pool=b']),
+      completion('a'),
+    ]);
+    expect(lc.confsecClientDoRequest).toHaveBeenCalledTimes(3);
+    expect(cc.getCoalescedRequests()).toEqual(0);
+  });
+});
+
+describe('CONFSEC fetch response cache', () => {
+  let lc: MockLibconfsec;
+  let cc: client.ConfsecClient;
+
+  beforeEach(() => {
+    lc = new MockLibconfsec();
+    cc = new client.ConfsecClient({
+      apiUrl: API_URL,
+      apiKey: 'test',
+      responseCache: { maxBytes: 1024 * 1024, ttlMs: 60000 },
+      libconfsec: lc,
+    });
+    lc.confsecResponseGetMetadata.mockReturnValue(
+      Buffer.from(
+        JSON.stringify({
+          status_code: 200,
+          reason_phrase: 'OK',
+          http_version: 'HTTP/1.1',
+          url: '',
+          headers: [{ key: 'content-type', value: 'application/json' }],
+        })
+      )
+    );
+  });
+
+  afterEach(() => {
+    lc.reset();
+  });
+
+  function completion(headers: Record<string, string> = {}) {
+    return cc.getConfsecFetch()(url('/v1/completions'), {
+      method: 'POST',
+      headers,
+      body: JSON.stringify({ model: 'm', prompt: 'p', temperature: 0 }),
+    });
+  }
+
+  test('repeated requests are served from the cache', async () => {
+    lc.confsecResponseIsStreaming.mockReturnValue(false);
+    lc.confsecResponseGetBody.mockReturnValue(Buffer.from('{"test": 1}'));
+
+    expect(await (await completion()).json()).toEqual({ test: 1 });
+    const cached = await completion();
+    expect(cached.status).toEqual(200);
+    expect(cached.headers.get('content-type')).toEqual('application/json');
+    expect(await cached.json()).toEqual({ test: 1 });
+
+    expect(lc.confsecClientDoRequest).toHaveBeenCalledTimes(1);
+    expect(cc.getCacheStats()).toMatchObject({ hits: 1, misses: 1 });
+  });
+
+  test('streamed responses are cached once fully read', async () => {
+    lc.confsecResponseIsStreaming.mockReturnValue(true);
+    lc.confsecResponseGetStream.mockReturnValue(1);
+    lc.confsecResponseStreamGetNext
+      .mockReturnValueOnce(Buffer.from('foo,'))
+      .mockReturnValueOnce(Buffer.from('bar'))
+      .mockReturnValueOnce(null);
+
+    expect(await (await completion()).text()).toEqual('foo,bar');
+    expect(await (await completion()).text()).toEqual('foo,bar');
+    expect(lc.confsecClientDoRequest).toHaveBeenCalledTimes(1);
+  });
+
+  test('error responses and no-store requests are not cached', async () => {
+    lc.confsecResponseGetMetadata.mockReturnValue(
+      Buffer.from(
+        JSON.stringify({
+          status_code: 500,
+          reason_phrase: 'Internal Server Error',
+          http_version: 'HTTP/1.1',
+          url: '',
+          headers: [],
+        })
+      )
+    );
+    lc.confsecResponseIsStreaming.mockReturnValue(false);
+    lc.confsecResponseGetBody.mockReturnValue(Buffer.from('{}'));
+
+    await (await completion()).text();
+    await (await completion()).text();
+    await (await completion({ 'cache-control': 'no-store' })).text();
+    expect(lc.confsecClientDoRequest).toHaveBeenCalledTimes(3);
+    expect(cc.getCacheStats()).toMatchObject({ entries: 0 });
+  });
+});
+
+describe('CONFSEC fetch hedging', () => {
+  test('hedged clients send requests asynchronously', async () => {
+    const lc = new MockLibconfsec();
+    const cc = new client.ConfsecClient({
+      apiUrl: API_URL,
+      apiKey: 'test',
+      hedging: { delayMs: 1000 },
+      libconfsec: lc,
+    });
+    lc.confsecClientDoRequestAsync.mockResolvedValue(7);
+    lc.confsecResponseGetMetadata.mockReturnValue(
+      Buffer.from(
+        JSON.stringify({
+          status_code: 200,
+          reason_phrase: 'OK',
+          http_version: 'HTTP/1.1',
+          url: '',
+          headers: [],
+        })
+      )
+    );
+    lc.confsecResponseIsStreaming.mockReturnValue(false);
+    lc.confsecResponseGetBody.mockReturnValue(Buffer.from('ok'));
+
+    const response = await cc.getConfsecFetch()(url('/v1/completions'), {
+      method: 'POST',
+      body: '{}',
+    });
+    expect(await response.text()).toEqual('ok');
+    expect(lc.confsecClientDoRequest).not.toHaveBeenCalled();
+    expect(lc.confsecClientDoRequestAsync).toHaveBeenCalledTimes(1);
+    expect(lc.confsecResponseDestroy).toHaveBeenCalledWith(7);
+    expect(cc.getHedgingStats()).toMatchObject({ requests: 1, hedges: 0 });
+  });
+
+  test('closing the client waits for async requests', async () => {
+    const lc = new MockLibconfsec();
+    lc.confsecClientCreate.mockReturnValue(1);
+    const cc = new client.ConfsecClient({
+      apiUrl: API_URL,
+      apiKey: 'test',
+      libconfsec: lc,
+    });
+    let resolve!: (handle: number) => void;
+    lc.confsecClientDoRequestAsync.mockReturnValue(
+      new Promise<number>(r => (resolve = r))
+    );
+
+    const pending = cc.doRequestAsync('foo');
+    cc.close();
+    expect(lc.confsecClientDestroy).not.toHaveBeenCalled();
+
+    resolve(2);
+    await expect(pending).rejects.toThrow('Client is closed');
+    expect(lc.confsecResponseDestroy).toHaveBeenCalledWith(2);
+    expect(lc.confsecClientDestroy).toHaveBeenCalledWith(1);
+  });
+});
+
+describe('CONFSEC fetch latency histograms', () => {
+  test('records streamed completions by model', async () => {
+    const lc = new MockLibconfsec();
+    const cc = new client.ConfsecClient({
+      apiUrl: API_URL,
+      apiKey: 'test',
+      latencyHistograms: {},
+      libconfsec: lc,
+    });
+    lc.confsecResponseGetMetadata.mockReturnValue(
+      Buffer.from(
+        JSON.stringify({
+          status_code: 200,
+          reason_phrase: 'OK',
+          http_version: 'HTTP/1.1',
+          url: '',
+          headers: [],
+        })
+      )
+    );
+    lc.confsecResponseIsStreaming.mockReturnValue(true);
+    lc.confsecResponseGetStream.mockReturnValue(1);
+    lc.confsecResponseStreamGetNext
+      .mockReturnValueOnce(Buffer.from('data: {"n":1}\n\n'))
+      .mockReturnValueOnce(Buffer.from('data: {"n":2}\n\ndata: [DONE]\n\n'))
+      .mockReturnValueOnce(null);
+
+    const confsecFetch = cc.getConfsecFetch();
+    const response = await confsecFetch(url('/v1/chat/completions'), {
+      method: 'POST',
+      body: JSON.stringify({ model: 'llama3.2:1b', stream: true }),
+    });
+    expect(cc.getLatencyHistograms()).toEqual({});
+    await response.text();
+
+    const histograms = cc.getLatencyHistograms()!;
+    expect(Object.keys(histograms)).toEqual(['llama3.2:1b']);
+    expect(histograms['llama3.2:1b'].ttfbMs.count).toBe(1);
+    expect(histograms['llama3.2:1b'].ttftMs.count).toBe(1);
+    expect(histograms['llama3.2:1b'].totalMs.count).toBe(1);
+
+    cc.resetLatencyHistograms();
+    expect(cc.getLatencyHistograms()).toEqual({});
+    cc.close();
+  });
+
+  test('are disabled by default', () => {
+    const cc = new client.ConfsecClient({
+      apiUrl: API_URL,
+      apiKey: 'test',
+      libconfsec: new MockLibconfsec(),
+    });
+    expect(cc.getLatencyHistograms()).toBeNull();
+  });
+});
+
+describe('CONFSEC fetch request buffers', () => {
+  const metadata = Buffer.from(
+    JSON.stringify({
+      status_code: 200,
+      reason_phrase: 'OK',
+      http_version: 'HTTP/1.1',
+      url: '',
+      headers: [],
+    })
+  );
+
+  test('reuses the request buffer across requests', async () => {
+    const lc = new MockLibconfsec();
+    const cc = new client.ConfsecClient({
+      apiUrl: API_URL,
+      apiKey: 'test',
+      libconfsec: lc,
+    });
+    lc.confsecResponseGetMetadata.mockReturnValue(metadata);
+    lc.confsecResponseIsStreaming.mockReturnValue(false);
+    lc.confsecResponseGetBody.mockReturnValue(Buffer.from('ok'));
+
+    const confsecFetch = cc.getConfsecFetch();
+    for (const body of ['{"a": 1}', '{"b": 2}']) {
+      await (
+        await confsecFetch(url('/v1/completions'), { method: 'POST', body })
+      ).text();
+    }
+    const requests = lc.confsecClientDoRequest.mock.calls.map(call =>
+      (call[1] as Buffer).toString()
+    );
+    expect(requests[1]).toContain('{"b": 2}');
+    expect(cc.getRequestBufferPoolStats()).toEqual({
+      reused: 1,
+      allocated: 1,
+      inUse: 0,
+      idleBytes: 1024,
+    });
+  });
+
+  test('keeps the buffer until hedged attempts settle', async () => {
+    const lc = new MockLibconfsec();
+    const cc = new client.ConfsecClient({
+      apiUrl: API_URL,
+      apiKey: 'test',
+      hedging: { delayMs: 0, maxHedgeRatio: 1 },
+      libconfsec: lc,
+    });
+    let resolveFirst!: (handle: number) => void;
+    lc.confsecClientDoRequestAsync
+      .mockReturnValueOnce(new Promise<number>(r => (resolveFirst = r)))
+      .mockResolvedValueOnce(8);
+    lc.confsecResponseGetMetadata.mockReturnValue(metadata);
+    lc.confsecResponseIsStreaming.mockReturnValue(false);
+    lc.confsecResponseGetBody.mockReturnValue(Buffer.from('ok'));
+
+    const response = await cc.getConfsecFetch()(url('/v1/completions'), {
+      method: 'POST',
+      body: '{}',
+    });
+    expect(await response.text()).toEqual('ok');
+    expect(cc.getRequestBufferPoolStats()?.inUse).toBe(1);
+
+    resolveFirst(7);
+    await new Promise(resolve => setImmediate(resolve));
+    expect(lc.confsecResponseDestroy).toHaveBeenCalledWith(7);
+    expect(cc.getRequestBufferPoolStats()?.inUse).toBe(0);
+  });
+
+  test('allocates a buffer per request when disabled', () => {
+    const cc = new client.ConfsecClient({
+      apiUrl: API_URL,
+      apiKey: 'test',
+      requestBufferPool: false,
+      libconfsec: new MockLibconfsec(),
+    });
+    expect(cc.getRequestBufferPoolStats()).toBeNull();
+  });
+});
+
+describe('CONFSEC fetch static headers', () => {
+  test('are sent with every request until replaced', async () => {
+    const lc = new MockLibconfsec();
+    const cc = new client.ConfsecClient({
+      apiUrl: API_URL,
+      apiKey: 'test',
+      staticHeaders: { 'user-agent': 'test/1.0' },
+      libconfsec: lc,
+    });
+    lc.confsecResponseGetMetadata.mockReturnValue(
+      Buffer.from(
+        JSON.stringify({
+          status_code: 200,
+          reason_phrase: 'OK',
+          http_version: 'HTTP/1.1',
+          url: '',
+          headers: [],
+        })
+      )
+    );
+    lc.confsecResponseIsStreaming.mockReturnValue(false);
+    lc.confsecResponseGetBody.mockReturnValue(Buffer.from('ok'));
+    // Request buffers are reused, so they are read as they are sent
+    const requests: string[] = [];
+    lc.confsecClientDoRequest.mockImplementation((_, request) => {
+      requests.push(request.toString());
+      return 1;
+    });
+
+    const confsecFetch = cc.getConfsecFetch();
+    await (await confsecFetch(url('/v1/models'))).text();
+    expect(cc.getStaticHeaders()).toEqual({ 'user-agent': 'test/1.0' });
+    cc.setStaticHeaders({ 'user-agent': 'test/2.0' });
+    await (await confsecFetch(url('/v1/models'))).text();
+
+    expect(requests[0]).toContain('user-agent: test/1.0\r\n');
+    expect(requests[1]).toContain('user-agent: test/2.0\r\n');
+  });
 });
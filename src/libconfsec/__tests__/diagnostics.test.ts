@@ -0,0 +1,147 @@
+import { subscribe, unsubscribe } from 'diagnostics_channel';
+import { ConfsecClient } from '../client';
+import { DIAGNOSTICS_CHANNELS } from '../diagnostics';
+import { MockLibconfsec } from './utils/mocks';
+
+const API_URL = 'https://api.openpcc-example.com';
+const COMPLETIONS_URL = 'https://confsec.invalid/v1/completions';
+
+type ChannelName = keyof typeof DIAGNOSTICS_CHANNELS;
+
+describe('Diagnostics channels', () => {
+  let lc: MockLibconfsec;
+  let client: ConfsecClient;
+  let events: [ChannelName, Record<string, unknown>][];
+  let listeners: [string, (message: unknown) => void][];
+
+  beforeEach(() => {
+    lc = new MockLibconfsec();
+    client = new ConfsecClient({
+      apiUrl: API_URL,
+      apiKey: 'test',
+      retry: false,
+      libconfsec: lc,
+    });
+    lc.confsecResponseGetMetadata.mockReturnValue(
+      Buffer.from(
+        JSON.stringify({
+          status_code: 200,
+          reason_phrase: 'OK',
+          http_version: 'HTTP/1.1',
+          url: '',
+          headers: [],
+        })
+      )
+    );
+
+    events = [];
+    listeners = Object.entries(DIAGNOSTICS_CHANNELS).map(([name, channel]) => {
+      const listener = (message: unknown) => {
+        events.push([name as ChannelName, message as Record<string, unknown>]);
+      };
+      subscribe(channel, listener);
+      return [channel, listener];
+    });
+  });
+
+  afterEach(() => {
+    listeners.forEach(([channel, listener]) => unsubscribe(channel, listener));
+    lc.reset();
+  });
+
+  test('publish the lifecycle of a streamed request', async () => {
+    lc.confsecResponseIsStreaming.mockReturnValue(true);
+    lc.confsecResponseGetStream.mockReturnValue(1);
+    lc.confsecResponseStreamGetNext
+      .mockReturnValueOnce(Buffer.from('a'))
+      .mockReturnValueOnce(Buffer.from('b'))
+      .mockReturnValueOnce(null);
+
+    const response = await client.getConfsecFetch()(COMPLETIONS_URL, {
+      method: 'POST',
+      body: '{}',
+    });
+    await response.text();
+
+    expect(events.map(([name]) => name)).toEqual([
+      'start',
+      'headers',
+      'chunk',
+      'chunk',
+      'end',
+    ]);
+    const request = events[0][1].request as Request;
+    expect(request.url).toEqual(COMPLETIONS_URL);
+    events.forEach(([, message]) => expect(message.request).toBe(request));
+    expect(events[2][1].chunk).toEqual(Buffer.from('a'));
+    const timings = events[4][1].timings as Record<string, number>;
+    expect(timings.closed).toBeGreaterThanOrEqual(timings.queued);
+  });
+
+  test('publish failed requests and stream errors', async () => {
+    const confsecFetch = client.getConfsecFetch();
+    lc.confsecClientDoRequest.mockImplementationOnce(() => {
+      throw new Error('no nodes available');
+    });
+    await expect(
+      confsecFetch(COMPLETIONS_URL, { method: 'POST', body: '{}' })
+    ).rejects.toThrow('no nodes available');
+    expect(events.map(([name]) => name)).toEqual(['start', 'error']);
+
+    events = [];
+    lc.confsecResponseIsStreaming.mockReturnValue(true);
+    lc.confsecResponseGetStream.mockReturnValue(1);
+    lc.confsecResponseStreamGetNext.mockImplementationOnce(() => {
+      throw new Error('connection reset by peer');
+    });
+    const response = await confsecFetch(COMPLETIONS_URL, {
+      method: 'POST',
+      body: '{}',
+    });
+    await expect(response.text()).rejects.toThrow();
+    expect(events.map(([name]) => name)).toEqual(['start', 'headers', 'error']);
+  });
+
+  test('pair start and end for cached and coalesced responses', async () => {
+    const sharingClient = new ConfsecClient({
+      apiUrl: API_URL,
+      apiKey: 'test',
+      coalesceRequests: true,
+      responseCache: {},
+      libconfsec: lc,
+    });
+    lc.confsecResponseIsStreaming.mockReturnValue(true);
+    lc.confsecResponseGetStream.mockReturnValue(1);
+    lc.confsecResponseStreamGetNext
+      .mockReturnValueOnce(Buffer.from('a'))
+      .mockReturnValueOnce(null);
+
+    const confsecFetch = sharingClient.getConfsecFetch();
+    const completion = () =>
+      confsecFetch(COMPLETIONS_URL, { method: 'POST', body: '{}' });
+    const [leader, follower] = await Promise.all([completion(), completion()]);
+    expect(await leader.text()).toEqual('a');
+    expect(await follower.text()).toEqual('a');
+    expect(await (await completion()).text()).toEqual('a');
+    expect(lc.confsecClientDoRequest).toHaveBeenCalledTimes(1);
+
+    const starts = events.filter(([name]) => name === 'start');
+    const ends = events.filter(([name]) => name === 'end');
+    expect(starts).toHaveLength(3);
+    expect(ends.map(([, message]) => message.request)).toEqual(
+      expect.arrayContaining(starts.map(([, message]) => message.request))
+    );
+    expect(ends.map(([, message]) => message.source).sort()).toEqual([
+      'cache',
+      'coalesced',
+      'network',
+    ]);
+    const headers = events.filter(([name]) => name === 'headers');
+    expect(headers.map(([, message]) => message.source).sort()).toEqual([
+      'cache',
+      'coalesced',
+      'network',
+    ]);
+    sharingClient.close();
+  });
+});
@@ -0,0 +1,46 @@
+import { StaticHeaders } from '../headers';
+
+describe('StaticHeaders', () => {
+  test('encodes the host and static header lines once per host', () => {
+    const headers = new StaticHeaders({ 'User-Agent': 'test/1.0' });
+    expect(headers.headers).toEqual({ 'user-agent': 'test/1.0' });
+
+    const block = headers.encode('confsec.invalid', new Headers());
+    expect(block.toString()).toEqual(
+      'host: confsec.invalid\r\nuser-agent: test/1.0\r\n'
+    );
+    expect(headers.encode('confsec.invalid', new Headers())).toBe(block);
+    expect(headers.encode('other.invalid', new Headers()).toString()).toEqual(
+      'host: other.invalid\r\nuser-agent: test/1.0\r\n'
+    );
+  });
+
+  test('leaves out headers set on the request', () => {
+    const headers = new StaticHeaders({
+      'user-agent': 'test/1.0',
+      'x-team': 'a',
+    });
+    const block = headers.encode('confsec.invalid', new Headers());
+    const requestHeaders = new Headers({ host: 'h', 'user-agent': 'other' });
+    const overridden = headers.encode('confsec.invalid', requestHeaders);
+    expect(overridden.toString()).toEqual('x-team: a\r\n');
+    expect(headers.encode('confsec.invalid', new Headers())).toBe(block);
+  });
+
+  test('reuses the encoded lines of headers set to the same values', () => {
+    const headers = new StaticHeaders({
+      'user-agent': 'test/1.0',
+      'x-team': 'a',
+    });
+    const block = headers.encode('confsec.invalid', new Headers());
+    const requestHeaders = new Headers({ 'user-agent': 'test/1.0' });
+    expect(headers.encode('confsec.invalid', requestHeaders)).toBe(block);
+    expect(headers.covers('user-agent', 'test/1.0')).toBe(true);
+    expect(headers.covers('user-agent', 'other')).toBe(false);
+    expect(headers.covers('accept', '*/*')).toBe(false);
+  });
+
+  test('rejects invalid header names', () => {
+    expect(() => new StaticHeaders({ 'bad name': 'x' })).toThrow();
+  });
+});
@@ -0,0 +1,169 @@
+import { Hedger, LatencyWindow, RequestBudget } from '../hedge';
+
+class FakeResponse {
+  readonly name: string;
+  closed = false;
+
+  constructor(name: string) {
+    this.name = name;
+  }
+
+  close(): void {
+    this.closed = true;
+  }
+}
+
+interface Deferred<T> {
+  promise: Promise<T>;
+  resolve: (value: T) => void;
+  reject: (error: Error) => void;
+}
+
+function deferred<T>(): Deferred<T> {
+  let resolve!: (value: T) => void;
+  let reject!: (error: Error) => void;
+  const promise = new Promise<T>((res, rej) => {
+    resolve = res;
+    reject = rej;
+  });
+  return { promise, resolve, reject };
+}
+
+async function flush(): Promise<void> {
+  for (let i = 0; i < 5; i++) {
+    await Promise.resolve();
+  }
+}
+
+describe('LatencyWindow', () => {
+  test('computes percentiles over the most recent samples', () => {
+    const window = new LatencyWindow(100);
+    expect(window.percentile(95)).toBeNull();
+    for (let i = 1; i <= 200; i++) {
+      window.record(i);
+    }
+    expect(window.size).toEqual(100);
+    expect(window.percentile(50)).toEqual(150);
+    expect(window.percentile(95)).toEqual(195);
+  });
+});
+
+describe('RequestBudget', () => {
+  test('allows extra requests in proportion to requests', () => {
+    const budget = new RequestBudget(0.5);
+    budget.deposit();
+    expect(budget.withdraw()).toBe(false);
+    budget.deposit();
+    expect(budget.withdraw()).toBe(true);
+    expect(budget.withdraw()).toBe(false);
+  });
+
+  test('starts with initial credit unless the ratio is zero', () => {
+    const budget = new RequestBudget(0.5, 2);
+    expect(budget.withdraw()).toBe(true);
+    expect(budget.withdraw()).toBe(true);
+    expect(budget.withdraw()).toBe(false);
+    expect(new RequestBudget(0, 2).withdraw()).toBe(false);
+  });
+});
+
+describe('Hedger', () => {
+  beforeEach(() => {
+    jest.useFakeTimers();
+  });
+
+  afterEach(() => {
+    jest.useRealTimers();
+  });
+
+  test('fast responses are not hedged', async () => {
+    const hedger = new Hedger<FakeResponse>({ delayMs: 100, maxHedgeRatio: 1 });
+    const attempt = jest.fn(() => Promise.resolve(new FakeResponse('a')));
+    const response = await hedger.send(attempt);
+    jest.advanceTimersByTime(200);
+    expect(response.name).toEqual('a');
+    expect(attempt).toHaveBeenCalledTimes(1);
+    expect(hedger.stats).toMatchObject({ requests: 1, hedges: 0 });
+  });
+
+  test('slow responses are hedged and the loser is closed', async () => {
+    const hedger = new Hedger<FakeResponse>({ delayMs: 100, maxHedgeRatio: 1 });
+    const attempts = [deferred<FakeResponse>(), deferred<FakeResponse>()];
+    let calls = 0;
+    const result = hedger.send(() => attempts[calls++].promise);
+
+    jest.advanceTimersByTime(100);
+    expect(calls).toEqual(2);
+
+    const hedge = new FakeResponse('hedge');
+    attempts[1].resolve(hedge);
+    expect(await result).toBe(hedge);
+
+    const original = new FakeResponse('original');
+    attempts[0].resolve(original);
+    await flush();
+    expect(original.closed).toBe(true);
+    expect(hedge.closed).toBe(false);
+    expect(hedger.stats).toMatchObject({ hedges: 1, hedgeWins: 1 });
+  });
+
+  test('a new client hedges its first slow request', async () => {
+    const hedger = new Hedger<FakeResponse>({ delayMs: 100 });
+    const pending = deferred<FakeResponse>();
+    const attempt = jest.fn(() => pending.promise);
+
+    void hedger.send(attempt);
+    jest.advanceTimersByTime(100);
+    expect(attempt).toHaveBeenCalledTimes(2);
+    expect(hedger.stats).toMatchObject({ requests: 1, hedges: 1 });
+
+    pending.resolve(new FakeResponse('a'));
+    await flush();
+  });
+
+  test('hedges are limited by the budget', async () => {
+    const hedger = new Hedger<FakeResponse>({
+      delayMs: 100,
+      maxHedgeRatio: 0.5,
+    });
+    const pending = deferred<FakeResponse>();
+    const attempt = jest.fn(() => pending.promise);
+    const send = () => {
+      void hedger.send(attempt);
+      jest.advanceTimersByTime(100);
+    };
+
+    // The initial credit covers 19 hedges, as each request earns half of one
+    for (let i = 0; i < 19; i++) send();
+    expect(hedger.stats).toMatchObject({ hedges: 19, budgetExhausted: 0 });
+    send();
+    expect(hedger.stats).toMatchObject({ hedges: 19, budgetExhausted: 1 });
+    send();
+    expect(hedger.stats).toMatchObject({ hedges: 20, budgetExhausted: 1 });
+
+    pending.resolve(new FakeResponse('a'));
+    await flush();
+  });
+
+  test('failures are surfaced without hedging', async () => {
+    const hedger = new Hedger<FakeResponse>({ delayMs: 100, maxHedgeRatio: 1 });
+    const attempt = jest.fn(() => Promise.reject(new Error('boom')));
+    await expect(hedger.send(attempt)).rejects.toThrow('boom');
+    jest.advanceTimersByTime(100);
+    expect(attempt).toHaveBeenCalledTimes(1);
+  });
+
+  test('a failed attempt waits for the other attempt', async () => {
+    const hedger = new Hedger<FakeResponse>({ delayMs: 100, maxHedgeRatio: 1 });
+    const attempts = [deferred<FakeResponse>(), deferred<FakeResponse>()];
+    let calls = 0;
+    const result = hedger.send(() => attempts[calls++].promise);
+
+    jest.advanceTimersByTime(100);
+    attempts[0].reject(new Error('boom'));
+    await flush();
+    const hedge = new FakeResponse('hedge');
+    attempts[1].resolve(hedge);
+    expect(await result).toBe(hedge);
+  });
+});
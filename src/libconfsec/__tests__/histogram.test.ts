@@ -0,0 +1,130 @@
+import {
+  Histogram,
+  LatencyHistograms,
+  OTHER_MODELS,
+  TokenCounts,
+  countTokens,
+} from '../histogram';
+
+describe('Histogram', () => {
+  test('percentiles are within 1% of the recorded values', () => {
+    const histogram = new Histogram();
+    for (let i = 1; i <= 10000; i++) {
+      histogram.record(i);
+    }
+    const snapshot = histogram.snapshot();
+    expect(snapshot.count).toBe(10000);
+    expect(snapshot.min).toBe(1);
+    expect(snapshot.max).toBe(10000);
+    expect(snapshot.mean).toBeCloseTo(5000.5);
+    expect(Math.abs(snapshot.p50 - 5000) / 5000).toBeLessThan(0.01);
+    expect(Math.abs(snapshot.p99 - 9900) / 9900).toBeLessThan(0.01);
+    expect(snapshot.p999).toBeLessThanOrEqual(10000);
+  });
+
+  test('percentiles are within 1/128 at the start of wide buckets', () => {
+    for (let shift = 1; shift <= 20; shift++) {
+      const histogram = new Histogram(1);
+      // Just above the start of a bucket 2 ** shift wide
+      const value = 64 * 2 ** shift + 1;
+      histogram.record(value);
+      histogram.record(value * 4);
+      const error = Math.abs(histogram.percentile(50) - value) / value;
+      expect(error).toBeLessThan(1 / 128);
+    }
+  });
+
+  test('small values are exact at the configured scale', () => {
+    const histogram = new Histogram(1000);
+    histogram.record(0.002);
+    histogram.record(0.005);
+    expect(histogram.percentile(50)).toBe(0.002);
+    expect(histogram.percentile(100)).toBe(0.005);
+  });
+
+  test('ignores invalid values and resets', () => {
+    const histogram = new Histogram();
+    histogram.record(-1);
+    histogram.record(NaN);
+    histogram.record(Infinity);
+    expect(histogram.snapshot().count).toBe(0);
+
+    histogram.record(5);
+    histogram.reset();
+    expect(histogram.snapshot()).toEqual({
+      count: 0,
+      min: 0,
+      max: 0,
+      mean: 0,
+      p50: 0,
+      p90: 0,
+      p99: 0,
+      p999: 0,
+    });
+  });
+});
+
+describe('LatencyHistograms', () => {
+  test('records streamed responses', () => {
+    const histograms = new LatencyHistograms();
+    histograms.record(
+      'llama',
+      {
+        queued: 0,
+        submitted: 1,
+        headersReceived: 50,
+        firstChunk: 100,
+        lastChunk: 1100,
+      },
+      { events: 101, completionTokens: null }
+    );
+    const snapshot = histograms.snapshot()['llama'];
+    expect(snapshot.ttfbMs.max).toBe(50);
+    expect(snapshot.ttftMs.max).toBe(100);
+    expect(snapshot.totalMs.max).toBe(1100);
+    expect(snapshot.tokensPerSecond.max).toBe(100);
+  });
+
+  test('records non-streaming responses', () => {
+    const histograms = new LatencyHistograms();
+    histograms.record(
+      'llama',
+      { queued: 0, submitted: 0, headersReceived: 500, lastChunk: 501 },
+      { events: 0, completionTokens: 50 }
+    );
+    const snapshot = histograms.snapshot()['llama'];
+    expect(snapshot.ttftMs.count).toBe(0);
+    expect(snapshot.totalMs.max).toBe(501);
+    expect(snapshot.tokensPerSecond.max).toBe(100);
+  });
+
+  test('bounds the number of models', () => {
+    const histograms = new LatencyHistograms({ maxModels: 2 });
+    const timings = { queued: 0, headersReceived: 10 };
+    const tokens = { events: 0, completionTokens: null };
+    ['a', 'b', 'c', 'd', 'a'].forEach(model =>
+      histograms.record(model, timings, tokens)
+    );
+    const snapshot = histograms.snapshot();
+    expect(Object.keys(snapshot)).toEqual(['a', 'b', OTHER_MODELS]);
+    expect(snapshot['a'].ttfbMs.count).toBe(2);
+    expect(snapshot[OTHER_MODELS].ttfbMs.count).toBe(2);
+
+    histograms.reset();
+    expect(histograms.snapshot()).toEqual({});
+  });
+});
+
+describe('countTokens', () => {
+  test('counts SSE events and reported usage', () => {
+    const counts: TokenCounts = { events: 0, completionTokens: null };
+    countTokens(Buffer.from('data: {"a":1}\n\ndata: {"a":2}\n\n'), counts);
+    countTokens(
+      Buffer.from(
+        'data: {"usage":{"completion_tokens": 42}}\n\ndata: [DONE]\n\n'
+      ),
+      counts
+    );
+    expect(counts).toEqual({ events: 3, completionTokens: 42 });
+  });
+});
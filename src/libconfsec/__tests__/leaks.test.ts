@@ -0,0 +1,107 @@
+import { ConfsecClient } from '../client';
+import { HandleTracker } from '../leaks';
+import { LiveHandle } from '../types';
+import { MockLibconfsec } from './utils/mocks';
+
+const API_URL = 'https://api.openpcc-example.com';
+
+function liveHandle(
+  kind: LiveHandle['kind'],
+  handle: number,
+  ageMs: number
+): LiveHandle {
+  return { kind, handle, ageMs, stack: `    at create${handle}` };
+}
+
+describe('HandleTracker', () => {
+  let lc: MockLibconfsec;
+
+  beforeEach(() => {
+    jest.useFakeTimers();
+    lc = new MockLibconfsec();
+  });
+
+  afterEach(() => {
+    jest.useRealTimers();
+    lc.reset();
+  });
+
+  test('reports old responses and streams once per handle', () => {
+    const onReport = jest.fn();
+    const tracker = new HandleTracker(lc, {
+      reportAfterMs: 1000,
+      intervalMs: 500,
+      onReport,
+    });
+    expect(lc.confsecTrackHandles).toHaveBeenCalledWith(true);
+
+    lc.confsecGetLiveHandles.mockReturnValue([
+      liveHandle('client', 1, 5000),
+      liveHandle('response', 2, 1500),
+      liveHandle('stream', 3, 200),
+    ]);
+    jest.advanceTimersByTime(500);
+    expect(onReport).toHaveBeenCalledTimes(1);
+    expect(onReport).toHaveBeenLastCalledWith([
+      liveHandle('response', 2, 1500),
+    ]);
+
+    lc.confsecGetLiveHandles.mockReturnValue([
+      liveHandle('response', 2, 2000),
+      liveHandle('stream', 3, 1200),
+    ]);
+    jest.advanceTimersByTime(500);
+    expect(onReport).toHaveBeenCalledTimes(2);
+    expect(onReport).toHaveBeenLastCalledWith([liveHandle('stream', 3, 1200)]);
+
+    jest.advanceTimersByTime(500);
+    expect(onReport).toHaveBeenCalledTimes(2);
+
+    tracker.close();
+    expect(lc.confsecTrackHandles).toHaveBeenLastCalledWith(false);
+    jest.advanceTimersByTime(5000);
+    expect(lc.confsecGetLiveHandles).toHaveBeenCalledTimes(3);
+  });
+
+  test('reports a handle value again once it has been reused', () => {
+    const onReport = jest.fn();
+    const tracker = new HandleTracker(lc, { reportAfterMs: 0, onReport });
+    lc.confsecGetLiveHandles.mockReturnValue([liveHandle('response', 2, 10)]);
+    tracker.check();
+    lc.confsecGetLiveHandles.mockReturnValue([]);
+    tracker.check();
+    lc.confsecGetLiveHandles.mockReturnValue([liveHandle('response', 2, 10)]);
+    tracker.check();
+    expect(onReport).toHaveBeenCalledTimes(2);
+    tracker.close();
+  });
+});
+
+describe('ConfsecClient handle tracking', () => {
+  test('tracks handles while the client is open', () => {
+    const lc = new MockLibconfsec();
+    const handles = [liveHandle('response', 2, 10)];
+    lc.confsecGetLiveHandles.mockReturnValue(handles);
+    const client = new ConfsecClient({
+      apiUrl: API_URL,
+      apiKey: 'test',
+      handleTracking: {},
+      libconfsec: lc,
+    });
+    expect(lc.confsecTrackHandles).toHaveBeenCalledWith(true);
+    expect(client.getLiveHandles()).toEqual(handles);
+    client.close();
+    expect(lc.confsecTrackHandles).toHaveBeenLastCalledWith(false);
+  });
+
+  test('leaves tracking disabled by default', () => {
+    const lc = new MockLibconfsec();
+    const client = new ConfsecClient({
+      apiUrl: API_URL,
+      apiKey: 'test',
+      libconfsec: lc,
+    });
+    client.close();
+    expect(lc.confsecTrackHandles).not.toHaveBeenCalled();
+  });
+});
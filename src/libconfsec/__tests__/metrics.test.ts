@@ -0,0 +1,175 @@
+import { ConfsecClient } from '../client';
+import { Histogram } from '../histogram';
+import { PrometheusWriter } from '../metrics';
+import { MockLibconfsec } from './utils/mocks';
+
+const API_URL = 'https://api.openpcc-example.com';
+
+describe('PrometheusWriter', () => {
+  test('writes counters and gauges', () => {
+    const writer = new PrometheusWriter()
+      .metric('requests_total', 'counter', 'Requests', 3)
+      .metric('errors_total', 'counter', 'Errors', [
+        [{ code: 'a"b\\c' }, 1],
+        [{ code: 'd' }, Infinity],
+      ]);
+    expect(writer.toString()).toEqual(
+      [
+        '# HELP requests_total Requests',
+        '# TYPE requests_total counter',
+        'requests_total 3',
+        '# HELP errors_total Errors',
+        '# TYPE errors_total counter',
+        'errors_total{code="a\\"b\\\\c"} 1',
+        'errors_total{code="d"} +Inf',
+        '',
+      ].join('\n')
+    );
+  });
+
+  test('writes cumulative histogram buckets', () => {
+    const histogram = new Histogram();
+    [3, 8, 8, 40, 2000].forEach(value => histogram.record(value));
+    const writer = new PrometheusWriter().histogram(
+      'latency_seconds',
+      'Latency',
+      [{ labels: { model: 'm' }, histogram }],
+      [5, 10, 50],
+      0.001
+    );
+    expect(writer.toString()).toEqual(
+      [
+        '# HELP latency_seconds Latency',
+        '# TYPE latency_seconds histogram',
+        'latency_seconds_bucket{model="m",le="0.005"} 1',
+        'latency_seconds_bucket{model="m",le="0.01"} 3',
+        'latency_seconds_bucket{model="m",le="0.05"} 4',
+        'latency_seconds_bucket{model="m",le="+Inf"} 5',
+        'latency_seconds_sum{model="m"} 2.059',
+        'latency_seconds_count{model="m"} 5',
+        '',
+      ].join('\n')
+    );
+  });
+});
+
+describe('ConfsecClient.metrics', () => {
+  let lc: MockLibconfsec;
+  let client: ConfsecClient;
+
+  beforeEach(() => {
+    lc = new MockLibconfsec();
+    lc.confsecClientGetWalletStatus.mockReturnValue(
+      JSON.stringify({
+        credits_spent: 1,
+        credits_held: 2,
+        credits_available: 3,
+      })
+    );
+    lc.confsecGetStats.mockReturnValue({
+      liveClients: 1,
+      inFlightRequests: 0,
+      liveResponses: 0,
+      openStreams: 0,
+      nativeBytesOutstanding: 0,
+      requests: 7,
+      chunks: 0,
+      bytesDelivered: 0,
+      errors: { CONFSEC_NO_NODES: 2 },
+    });
+    const buckets = new Array(32).fill(0);
+    buckets[1] = 2;
+    buckets[11] = 1;
+    lc.confsecGetCallStats.mockReturnValue({
+      confsecClientDoRequest: { calls: 3, totalMs: 2, maxMs: 1.5, buckets },
+      confsecClientDestroy: {
+        calls: 0,
+        totalMs: 0,
+        maxMs: 0,
+        buckets: new Array(32).fill(0),
+      },
+    });
+    client = new ConfsecClient({
+      apiUrl: API_URL,
+      apiKey: 'test',
+      retry: {},
+      latencyHistograms: {},
+      libconfsec: lc,
+    });
+  });
+
+  afterEach(() => {
+    lc.reset();
+  });
+
+  test('renders wallet, native and retry metrics', () => {
+    const metrics = client.metrics();
+    expect(metrics).toContain('confsec_wallet_credits_available 3\n');
+    expect(metrics).toContain('confsec_wallet_credits_held 2\n');
+    expect(metrics).toContain('confsec_wallet_status_errors_total 0\n');
+    expect(metrics).toContain('confsec_fetch_requests_in_flight 0\n');
+    expect(metrics).toContain('confsec_native_requests_total 7\n');
+    expect(metrics).toContain(
+      'confsec_native_errors_total{code="CONFSEC_NO_NODES"} 2\n'
+    );
+    expect(metrics).toContain('confsec_retries_total 0\n');
+    expect(metrics).toContain('# TYPE confsec_ttfb_seconds histogram\n');
+    expect(metrics).not.toContain('confsec_hedges_total');
+    expect(metrics).not.toContain('confsec_cache_entries');
+  });
+
+  test('renders the background-refreshed wallet snapshot', () => {
+    lc.confsecClientReadWallet.mockImplementation(
+      (_: number, status: Float64Array) => {
+        status.set([25, 0, 15]);
+        return true;
+      }
+    );
+    lc.confsecClientStopWalletRefresh.mockResolvedValue(undefined);
+    const refreshed = new ConfsecClient({
+      apiUrl: API_URL,
+      apiKey: 'test',
+      walletRefreshMs: 1000,
+      libconfsec: lc,
+    });
+    const metrics = refreshed.metrics();
+    expect(metrics).toContain('confsec_wallet_credits_available 25\n');
+    expect(metrics).toContain('confsec_wallet_credits_spent 15\n');
+    expect(lc.confsecClientGetWalletStatus).not.toHaveBeenCalled();
+    refreshed.close();
+  });
+
+  test('renders native call durations for functions that were called', () => {
+    const metrics = client.metrics();
+    const series = 'confsec_native_call_seconds_bucket';
+    const labels = 'function="confsecClientDoRequest"';
+    expect(metrics).toContain(`${series}{${labels},le="0.000001"} 0\n`);
+    expect(metrics).toContain(`${series}{${labels},le="0.000004"} 2\n`);
+    expect(metrics).toContain(`${series}{${labels},le="0.001024"} 2\n`);
+    expect(metrics).toContain(`${series}{${labels},le="0.004096"} 3\n`);
+    expect(metrics).toContain(`${series}{${labels},le="+Inf"} 3\n`);
+    expect(metrics).toContain(
+      `confsec_native_call_seconds_sum{${labels}} 0.002\n`
+    );
+    expect(metrics).not.toContain('confsecClientDestroy');
+  });
+
+  test('renders the other metrics when the wallet status fails', () => {
+    lc.confsecClientGetWalletStatus.mockImplementation(() => {
+      throw new Error('wallet unavailable');
+    });
+    const metrics = client.metrics();
+    expect(metrics).not.toContain('confsec_wallet_credits_available');
+    expect(metrics).toContain('confsec_wallet_status_errors_total 1\n');
+    expect(metrics).toContain('confsec_native_requests_total 7\n');
+    expect(client.metrics()).toContain(
+      'confsec_wallet_status_errors_total 2\n'
+    );
+  });
+
+  test('reuses the wallet status between scrapes', () => {
+    client.metrics();
+    client.metrics();
+    expect(lc.confsecClientGetWalletStatus).toHaveBeenCalledTimes(1);
+  });
+});
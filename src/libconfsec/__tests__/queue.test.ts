@@ -0,0 +1,87 @@
+import { ConfsecOverloadError } from '../errors';
+import { RequestQueue } from '../queue';
+
+describe('RequestQueue', () => {
+  afterEach(() => {
+    jest.useRealTimers();
+  });
+
+  test('admits requests up to the concurrency limit', async () => {
+    const queue = new RequestQueue({ maxConcurrentRequests: 2 });
+    await queue.acquire();
+    await queue.acquire();
+    expect(queue.inFlight).toBe(2);
+    expect(queue.depth).toBe(0);
+  });
+
+  test('hands released slots to waiters in order', async () => {
+    const queue = new RequestQueue({ maxConcurrentRequests: 1 });
+    const release = await queue.acquire();
+    const order: number[] = [];
+    const first = queue.acquire().then(r => {
+      order.push(1);
+      return r;
+    });
+    const second = queue.acquire().then(r => {
+      order.push(2);
+      return r;
+    });
+    expect(queue.depth).toBe(2);
+
+    release();
+    (await first)();
+    (await second)();
+    expect(order).toEqual([1, 2]);
+    expect(queue.inFlight).toBe(0);
+  });
+
+  test('releasing twice frees one slot', async () => {
+    const queue = new RequestQueue({ maxConcurrentRequests: 2 });
+    const release = await queue.acquire();
+    await queue.acquire();
+    release();
+    release();
+    expect(queue.inFlight).toBe(1);
+  });
+
+  test('rejects immediately when the queue is full', async () => {
+    const queue = new RequestQueue({
+      maxConcurrentRequests: 1,
+      maxQueueDepth: 1,
+    });
+    await queue.acquire();
+    void queue.acquire();
+
+    const rejected = queue.acquire();
+    await expect(rejected).rejects.toBeInstanceOf(ConfsecOverloadError);
+    await expect(rejected).rejects.toMatchObject({
+      code: 'CONFSEC_OVERLOADED',
+      reason: 'queue_full',
+    });
+    expect(queue.rejectedQueueFull).toBe(1);
+  });
+
+  test('rejects requests that wait too long', async () => {
+    jest.useFakeTimers();
+    const queue = new RequestQueue({
+      maxConcurrentRequests: 1,
+      maxQueueWaitMs: 50,
+    });
+    await queue.acquire();
+
+    const waiting = queue.acquire();
+    jest.advanceTimersByTime(50);
+    await expect(waiting).rejects.toMatchObject({ reason: 'queue_timeout' });
+    expect(queue.depth).toBe(0);
+    expect(queue.rejectedQueueTimeout).toBe(1);
+  });
+
+  test('close rejects waiting requests', async () => {
+    const queue = new RequestQueue({ maxConcurrentRequests: 1 });
+    await queue.acquire();
+    const waiting = queue.acquire();
+    queue.close();
+    await expect(waiting).rejects.toThrow('Client is closed');
+    await expect(queue.acquire()).rejects.toThrow('Client is closed');
+  });
+});
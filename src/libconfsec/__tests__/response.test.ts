@@ -1,4 +1,5 @@
 import { ConfsecClient } from '../client';
+import { formatTimings } from '../response';
 import { MockLibconfsec } from './utils/mocks';
 
 const API_URL = 'https://api.openpcc-example.com';
@@ -76,6 +77,40 @@ describe('ConfsecResponse', () => {
     response.close();
     expect(lc.confsecResponseDestroy).toHaveBeenCalledWith(response.handle);
   });
+
+  test('timings record each phase of a non-streaming response', () => {
+    lc.confsecClientDoRequest.mockReturnValue(1);
+    lc.confsecResponseGetBody.mockReturnValue(Buffer.from('foo'));
+    const response = client.doRequest('foo');
+    const { submitted, headersReceived } = response.timings;
+    expect(submitted).toBeLessThanOrEqual(headersReceived!);
+    expect(response.timings.firstChunk).toBeUndefined();
+
+    void response.body;
+    expect(response.timings.firstChunk).toBeGreaterThanOrEqual(
+      headersReceived!
+    );
+    expect(response.timings.lastChunk).toEqual(response.timings.firstChunk);
+
+    response.close();
+    expect(response.timings.closed).toBeGreaterThanOrEqual(
+      response.timings.lastChunk!
+    );
+  });
+
+  test('formatTimings reports milliseconds since the fetch call', () => {
+    expect(
+      formatTimings({
+        queued: 100,
+        serialized: 100.25,
+        submitted: 101.0004,
+        headersReceived: 150,
+      })
+    ).toEqual('serialized=0.25, submitted=1, headersReceived=50');
+    expect(formatTimings({ submitted: 10, headersReceived: 12.5 })).toEqual(
+      'submitted=0, headersReceived=2.5'
+    );
+  });
 });
 
 describe('ConfsecResponseStream', () => {
@@ -116,4 +151,82 @@ describe('ConfsecResponseStream', () => {
     expect(lc.confsecResponseStreamDestroy).toHaveBeenCalledWith(stream.handle);
     expect(lc.confsecResponseDestroy).toHaveBeenCalledWith(response.handle);
   });
+
+  test('timings record the first and last chunk of a stream', () => {
+    lc.confsecClientDoRequest.mockReturnValue(1);
+    lc.confsecResponseGetStream.mockReturnValue(2);
+    lc.confsecResponseStreamGetNext
+      .mockReturnValueOnce(Buffer.from('a'))
+      .mockReturnValueOnce(Buffer.from('b'))
+      .mockReturnValueOnce(null);
+    const response = client.doRequest('foo');
+    const stream = response.getStream();
+
+    stream.getNext();
+    const { firstChunk } = response.timings;
+    expect(firstChunk).toBeGreaterThanOrEqual(
+      response.timings.headersReceived!
+    );
+    expect(response.timings.lastChunk).toEqual(firstChunk);
+
+    expect(Array.from(stream)).toHaveLength(1);
+    expect(response.timings.firstChunk).toEqual(firstChunk);
+    expect(response.timings.lastChunk).toBeGreaterThanOrEqual(firstChunk!);
+    expect(response.timings.closed).toBeGreaterThanOrEqual(
+      response.timings.lastChunk!
+    );
+  });
+
+  test('async iteration records when each chunk was received', async () => {
+    lc.confsecClientDoRequest.mockReturnValue(1);
+    lc.confsecResponseGetStream.mockReturnValue(2);
+    lc.confsecResponseStreamGetNextAsync
+      .mockResolvedValueOnce({ chunk: Buffer.from('foo,'), delayMs: 5 })
+      .mockResolvedValueOnce({ chunk: Buffer.from('bar'), delayMs: 0 })
+      .mockResolvedValueOnce({ chunk: null, delayMs: 0 });
+    const response = client.doRequest('foo');
+    const stream = response.getStream();
+
+    const chunks: Buffer[] = [];
+    for await (const chunk of stream) {
+      chunks.push(chunk);
+    }
+    expect(chunks).toEqual([Buffer.from('foo,'), Buffer.from('bar')]);
+    expect(lc.confsecResponseStreamGetNext).not.toHaveBeenCalled();
+    expect(lc.confsecResponseStreamDestroy).toHaveBeenCalledWith(stream.handle);
+
+    const [first, second] = response.chunkTimings;
+    expect(response.chunkTimings).toHaveLength(2);
+    expect(first.bytes).toEqual(4);
+    expect(first.deliveredAt - first.receivedAt).toBeCloseTo(5);
+    expect(second.receivedAt).toEqual(second.deliveredAt);
+    expect(response.timings.firstChunk).toEqual(first.deliveredAt);
+    expect(response.timings.lastChunk).toEqual(second.deliveredAt);
+  });
+
+  test('closing during an async read defers destroying it', async () => {
+    lc.confsecClientDoRequest.mockReturnValue(1);
+    lc.confsecResponseGetStream.mockReturnValue(2);
+    let resolve: (value: unknown) => void = () => {};
+    lc.confsecResponseStreamGetNextAsync.mockReturnValue(
+      new Promise(r => {
+        resolve = r;
+      })
+    );
+    const response = client.doRequest('foo');
+    const stream = response.getStream();
+
+    const read = stream.getNextAsync();
+    await expect(stream.getNextAsync()).rejects.toThrow(
+      'A read is already in progress'
+    );
+    stream.close();
+    expect(lc.confsecResponseStreamDestroy).not.toHaveBeenCalled();
+
+    resolve({ chunk: null, delayMs: 0 });
+    await read;
+    await Promise.resolve();
+    expect(lc.confsecResponseStreamDestroy).toHaveBeenCalledWith(stream.handle);
+    expect(lc.confsecResponseDestroy).toHaveBeenCalledWith(response.handle);
+  });
 });
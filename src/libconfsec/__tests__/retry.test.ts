@@ -0,0 +1,119 @@
+import { getErrorCode, isTransientError } from '../errors';
+import { RetryPolicy, isIdempotent } from '../retry';
+
+function nativeError(code: string, transient: boolean): Error {
+  return Object.assign(new Error(code), { code, transient });
+}
+
+describe('error classification', () => {
+  test('reads the code and transient flag set by the binding', () => {
+    const error = nativeError('CONFSEC_NO_NODES', true);
+    expect(getErrorCode(error)).toEqual('CONFSEC_NO_NODES');
+    expect(isTransientError(error)).toBe(true);
+    expect(isTransientError(nativeError('CONFSEC_AUTH', false))).toBe(false);
+  });
+
+  test('other errors are not classified', () => {
+    expect(getErrorCode(new Error('boom'))).toBeNull();
+    expect(isTransientError(new Error('boom'))).toBe(false);
+    expect(isTransientError('boom')).toBe(false);
+  });
+});
+
+describe('isIdempotent', () => {
+  test('uses the method and idempotency key', () => {
+    const url = 'https://confsec.invalid/v1/completions';
+    expect(isIdempotent(new Request(url))).toBe(true);
+    expect(isIdempotent(new Request(url, { method: 'POST' }))).toBe(false);
+    expect(
+      isIdempotent(
+        new Request(url, {
+          method: 'POST',
+          headers: { 'Idempotency-Key': 'abc' },
+        })
+      )
+    ).toBe(true);
+  });
+});
+
+describe('RetryPolicy', () => {
+  test('transient failures are retried', async () => {
+    const policy = new RetryPolicy({ baseDelayMs: 0, maxRetryRatio: 1 });
+    const attempt = jest
+      .fn()
+      .mockRejectedValueOnce(nativeError('CONFSEC_NO_NODES', true))
+      .mockResolvedValueOnce('ok');
+    expect(await policy.send(attempt, false)).toEqual('ok');
+    expect(attempt).toHaveBeenCalledTimes(2);
+    expect(policy.stats).toEqual({
+      retries: 1,
+      recovered: 1,
+      budgetExhausted: 0,
+    });
+  });
+
+  test('permanent failures are not retried', async () => {
+    const policy = new RetryPolicy({ baseDelayMs: 0, maxRetryRatio: 1 });
+    const attempt = jest
+      .fn()
+      .mockRejectedValue(nativeError('CONFSEC_AUTH', false));
+    await expect(policy.send(attempt, true)).rejects.toThrow('CONFSEC_AUTH');
+    expect(attempt).toHaveBeenCalledTimes(1);
+  });
+
+  test('failures that may have reached a node need idempotency', async () => {
+    const policy = new RetryPolicy({ baseDelayMs: 0, maxRetryRatio: 1 });
+    const error = nativeError('CONFSEC_TIMEOUT', true);
+    const attempt = jest.fn().mockRejectedValue(error);
+    await expect(policy.send(attempt, false)).rejects.toBe(error);
+    expect(attempt).toHaveBeenCalledTimes(1);
+
+    attempt.mockClear();
+    await expect(policy.send(attempt, true)).rejects.toBe(error);
+    expect(attempt).toHaveBeenCalledTimes(3);
+  });
+
+  test("a new client's first transient failure is retried", async () => {
+    const policy = new RetryPolicy({ baseDelayMs: 0 });
+    const attempt = jest
+      .fn()
+      .mockRejectedValueOnce(nativeError('CONFSEC_NO_NODES', true))
+      .mockResolvedValueOnce('ok');
+    expect(await policy.send(attempt, false)).toEqual('ok');
+    expect(attempt).toHaveBeenCalledTimes(2);
+    expect(policy.stats).toMatchObject({ retries: 1, budgetExhausted: 0 });
+  });
+
+  test('retries are limited by the budget', async () => {
+    const policy = new RetryPolicy({
+      baseDelayMs: 0,
+      maxAttempts: 100,
+      maxRetryRatio: 0.5,
+    });
+    const attempt = jest
+      .fn()
+      .mockRejectedValue(nativeError('CONFSEC_NO_NODES', true));
+    // The initial credit covers 10 retries
+    await expect(policy.send(attempt, true)).rejects.toThrow();
+    expect(attempt).toHaveBeenCalledTimes(11);
+    expect(policy.stats).toMatchObject({ retries: 10, budgetExhausted: 1 });
+
+    attempt.mockClear();
+    await expect(policy.send(attempt, true)).rejects.toThrow();
+    expect(attempt).toHaveBeenCalledTimes(1);
+    expect(policy.stats.budgetExhausted).toEqual(2);
+
+    attempt.mockClear();
+    await expect(policy.send(attempt, true)).rejects.toThrow();
+    expect(attempt).toHaveBeenCalledTimes(2);
+  });
+
+  test('backoff grows exponentially up to the maximum', () => {
+    const policy = new RetryPolicy({ baseDelayMs: 100, maxDelayMs: 300 });
+    jest.spyOn(Math, 'random').mockReturnValue(0.999);
+    expect(policy.backoffMs(1)).toBeCloseTo(100, 0);
+    expect(policy.backoffMs(2)).toBeCloseTo(200, 0);
+    expect(policy.backoffMs(3)).toBeCloseTo(300, 0);
+    jest.restoreAllMocks();
+  });
+});
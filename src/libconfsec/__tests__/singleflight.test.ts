@@ -0,0 +1,116 @@
+import { SharedBody, SingleFlight, requestKey } from '../singleflight';
+
+function sourceOf(chunks: string[]): ReadableStream<Uint8Array> {
+  const encoder = new TextEncoder();
+  let i = 0;
+  return new ReadableStream<Uint8Array>({
+    pull(controller) {
+      if (i < chunks.length) {
+        controller.enqueue(encoder.encode(chunks[i++]));
+      } else {
+        controller.close();
+      }
+    },
+  });
+}
+
+async function readAll(stream: ReadableStream<Uint8Array>): Promise<string> {
+  return new Response(stream).text();
+}
+
+describe('requestKey', () => {
+  test('identical requests share a key', () => {
+    expect(requestKey(Buffer.from('POST / HTTP/1.1\r\n\r\n'))).toEqual(
+      requestKey(Buffer.from('POST / HTTP/1.1\r\n\r\n'))
+    );
+    expect(requestKey(Buffer.from('a'))).not.toEqual(
+      requestKey(Buffer.from('b'))
+    );
+  });
+
+  test('node tags are part of the key', () => {
+    const rawRequest = Buffer.from('POST / HTTP/1.1\r\n\r\n');
+    expect(requestKey(rawRequest, [])).toEqual(requestKey(rawRequest));
+    expect(requestKey(rawRequest, ['pool=a'])).not.toEqual(
+      requestKey(rawRequest)
+    );
+    expect(requestKey(rawRequest, ['pool=a'])).not.toEqual(
+      requestKey(rawRequest, ['pool=b'])
+    );
+  });
+});
+
+describe('SharedBody', () => {
+  test('every subscriber reads the whole body', async () => {
+    const body = new SharedBody(sourceOf(['foo,', 'bar,', 'baz']));
+    const first = body.subscribe();
+    const firstText = await readAll(first);
+    const second = body.subscribe();
+    expect(firstText).toEqual('foo,bar,baz');
+    expect(await readAll(second)).toEqual('foo,bar,baz');
+    expect(body.isComplete).toBe(true);
+  });
+
+  test('concurrent subscribers read the source once', async () => {
+    let pulls = 0;
+    const source = new ReadableStream<Uint8Array>({
+      pull(controller) {
+        if (pulls++ < 2) {
+          controller.enqueue(new Uint8Array([pulls]));
+        } else {
+          controller.close();
+        }
+      },
+    });
+    const body = new SharedBody(source);
+    const [a, b] = await Promise.all([
+      new Response(body.subscribe()).arrayBuffer(),
+      new Response(body.subscribe()).arrayBuffer(),
+    ]);
+    expect(new Uint8Array(a)).toEqual(new Uint8Array([1, 2]));
+    expect(new Uint8Array(b)).toEqual(new Uint8Array([1, 2]));
+    expect(pulls).toEqual(3);
+  });
+
+  test('cancelling every subscriber cancels the source', async () => {
+    const cancel = jest.fn();
+    const source = new ReadableStream<Uint8Array>({
+      pull(controller) {
+        controller.enqueue(new Uint8Array([1]));
+      },
+      cancel,
+    });
+    const body = new SharedBody(source);
+    const onComplete = jest.fn();
+    body.onComplete(onComplete);
+    await body.subscribe().cancel();
+    expect(cancel).toHaveBeenCalledTimes(1);
+    expect(onComplete).toHaveBeenCalledTimes(1);
+  });
+});
+
+describe('SingleFlight', () => {
+  test('concurrent calls with the same key share a result', async () => {
+    const flight = new SingleFlight<number>();
+    const fn = jest.fn().mockResolvedValue(42);
+    const results = await Promise.all([
+      flight.do('key', fn),
+      flight.do('key', fn),
+    ]);
+    expect(results).toEqual([42, 42]);
+    expect(fn).toHaveBeenCalledTimes(1);
+    expect(flight.coalesced).toEqual(1);
+  });
+
+  test('forgotten and failed flights are not reused', async () => {
+    const flight = new SingleFlight<number>();
+    await flight.do('key', () => Promise.resolve(1));
+    flight.forget('key');
+    expect(await flight.do('key', () => Promise.resolve(2))).toEqual(2);
+
+    await expect(
+      flight.do('other', () => Promise.reject(new Error('boom')))
+    ).rejects.toThrow('boom');
+    expect(await flight.do('other', () => Promise.resolve(3))).toEqual(3);
+  });
+});
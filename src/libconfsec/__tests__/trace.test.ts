@@ -0,0 +1,217 @@
+import { ConfsecClient } from '../client';
+import { MockLibconfsec } from './utils/mocks';
+
+const API_URL = 'https://api.openpcc-example.com';
+const COMPLETIONS_URL = 'https://confsec.invalid/v1/completions';
+
+describe('Tracing', () => {
+  let lc: MockLibconfsec;
+  let client: ConfsecClient;
+
+  beforeEach(() => {
+    lc = new MockLibconfsec();
+    client = new ConfsecClient({
+      apiUrl: API_URL,
+      apiKey: 'test',
+      retry: false,
+      libconfsec: lc,
+    });
+    lc.confsecResponseGetMetadata.mockReturnValue(
+      Buffer.from(
+        JSON.stringify({
+          status_code: 200,
+          reason_phrase: 'OK',
+          http_version: 'HTTP/1.1',
+          url: '',
+          headers: [],
+        })
+      )
+    );
+    lc.confsecTraceStop.mockReturnValue({
+      nowUs: 5000,
+      tid: 1,
+      spans: [
+        {
+          name: 'confsecClientDoRequest',
+          tid: 1,
+          startUs: 10,
+          endUs: 30,
+          id: 0,
+        },
+        {
+          name: 'Confsec_ClientDoRequest',
+          tid: 2,
+          startUs: 40,
+          endUs: 90,
+          id: 0,
+        },
+        { name: 'queued', tid: 1, startUs: 20, endUs: 40, id: 7 },
+      ],
+    });
+  });
+
+  afterEach(() => {
+    lc.reset();
+  });
+
+  test('converts native spans to trace events', () => {
+    client.startTracing({ capacity: 100 });
+    expect(lc.confsecTraceStart).toHaveBeenCalledWith(100);
+    const { traceEvents } = client.stopTracing();
+
+    const offset = traceEvents[0].ts - 10;
+    expect(traceEvents).toEqual(
+      expect.arrayContaining([
+        expect.objectContaining({
+          name: 'confsecClientDoRequest',
+          ph: 'X',
+          dur: 20,
+          tid: 1,
+        }),
+        expect.objectContaining({
+          name: 'Confsec_ClientDoRequest',
+          ph: 'X',
+          ts: 40 + offset,
+          tid: 2,
+        }),
+        expect.objectContaining({ name: 'queued', ph: 'b', id: 'native-7' }),
+        expect.objectContaining({
+          name: 'queued',
+          ph: 'e',
+          id: 'native-7',
+          ts: 40 + offset,
+        }),
+        expect.objectContaining({
+          name: 'thread_name',
+          ph: 'M',
+          tid: 1,
+          args: { name: 'JavaScript' },
+        }),
+        expect.objectContaining({ name: 'thread_name', ph: 'M', tid: 2 }),
+      ])
+    );
+  });
+
+  test('records the phases of fetch requests', async () => {
+    lc.confsecResponseIsStreaming.mockReturnValue(true);
+    lc.confsecResponseGetStream.mockReturnValue(1);
+    lc.confsecResponseStreamGetNext
+      .mockReturnValueOnce(Buffer.from('a'))
+      .mockReturnValueOnce(null);
+
+    client.startTracing();
+    const response = await client.getConfsecFetch()(COMPLETIONS_URL, {
+      method: 'POST',
+      body: '{}',
+    });
+    await response.text();
+    const { traceEvents } = client.stopTracing();
+
+    const requestEvents = traceEvents.filter(event => event.cat === 'request');
+    expect(requestEvents.map(({ ph, name }) => `${ph} ${name}`)).toEqual([
+      `b ${COMPLETIONS_URL}`,
+      'n chunk',
+      'b serialize',
+      'e serialize',
+      'b wait for slot',
+      'e wait for slot',
+      'b wait for headers',
+      'e wait for headers',
+      'b read body',
+      'e read body',
+      `e ${COMPLETIONS_URL}`,
+    ]);
+    requestEvents.forEach(event => {
+      expect(event.id).toEqual(requestEvents[0].id);
+      expect(event.tid).toEqual(1);
+    });
+  });
+
+  test('ends requests that fail before their response', async () => {
+    lc.confsecClientDoRequest.mockImplementationOnce(() => {
+      throw new Error('no nodes available');
+    });
+
+    client.startTracing();
+    await expect(
+      client.getConfsecFetch()(COMPLETIONS_URL, { method: 'POST', body: '{}' })
+    ).rejects.toThrow('no nodes available');
+    const { traceEvents } = client.stopTracing();
+
+    const requestEvents = traceEvents.filter(event => event.cat === 'request');
+    expect(requestEvents.map(({ ph, name }) => `${ph} ${name}`)).toEqual([
+      `b ${COMPLETIONS_URL}`,
+      'n error',
+      'b serialize',
+      'e serialize',
+      `e ${COMPLETIONS_URL}`,
+    ]);
+  });
+
+  test('ends cached and coalesced requests', async () => {
+    const sharingClient = new ConfsecClient({
+      apiUrl: API_URL,
+      apiKey: 'test',
+      coalesceRequests: true,
+      responseCache: {},
+      libconfsec: lc,
+    });
+    lc.confsecResponseIsStreaming.mockReturnValue(false);
+    lc.confsecResponseGetBody.mockReturnValue(Buffer.from('{}'));
+
+    sharingClient.startTracing();
+    const confsecFetch = sharingClient.getConfsecFetch();
+    const completion = () =>
+      confsecFetch(COMPLETIONS_URL, { method: 'POST', body: '{}' });
+    const responses = await Promise.all([completion(), completion()]);
+    responses.push(await completion());
+    for (const response of responses) {
+      await response.text();
+    }
+    const { traceEvents } = sharingClient.stopTracing();
+    sharingClient.close();
+
+    const requestSpans = traceEvents.filter(
+      event => event.cat === 'request' && event.name === COMPLETIONS_URL
+    );
+    const begins = requestSpans.filter(event => event.ph === 'b');
+    const ends = requestSpans.filter(event => event.ph === 'e');
+    expect(begins).toHaveLength(3);
+    expect(ends.map(event => event.id).sort()).toEqual(
+      begins.map(event => event.id).sort()
+    );
+  });
+
+  test('keeps the last capacity request events', async () => {
+    lc.confsecResponseIsStreaming.mockReturnValue(false);
+    lc.confsecResponseGetBody.mockReturnValue(Buffer.from('{}'));
+
+    client.startTracing({ capacity: 3 });
+    const confsecFetch = client.getConfsecFetch();
+    for (let i = 0; i < 2; i++) {
+      const response = await confsecFetch(COMPLETIONS_URL, {
+        method: 'POST',
+        body: '{}',
+      });
+      await response.text();
+    }
+    const { traceEvents } = client.stopTracing();
+
+    expect(traceEvents.filter(event => event.cat === 'request')).toHaveLength(
+      3
+    );
+    expect(traceEvents).toEqual(
+      expect.arrayContaining([
+        expect.objectContaining({ name: 'dropped request events' }),
+      ])
+    );
+  });
+
+  test('allows one trace at a time', () => {
+    expect(() => client.stopTracing()).toThrow('Tracing not started');
+    client.startTracing();
+    expect(() => client.startTracing()).toThrow('Tracing already started');
+    client.close();
+    expect(lc.confsecTraceStop).toHaveBeenCalledTimes(1);
+  });
+});
@@ -7,8 +7,14 @@ export class MockLibconfsec implements ILibconfsec {
   confsecClientGetMaxCandidateNodes = jest.fn();
   confsecClientGetDefaultNodeTags = jest.fn();
   confsecClientSetDefaultNodeTags = jest.fn();
+  confsecNodeTagSetCreate = jest.fn();
   confsecClientGetWalletStatus = jest.fn();
+  confsecClientStartWalletRefresh = jest.fn();
+  confsecClientReadWallet = jest.fn();
+  confsecClientRefreshWallet = jest.fn();
+  confsecClientStopWalletRefresh = jest.fn();
   confsecClientDoRequest = jest.fn();
+  confsecClientDoRequestAsync = jest.fn();
 
   confsecResponseDestroy = jest.fn();
   confsecResponseGetMetadata = jest.fn();
@@ -18,6 +24,16 @@ export class MockLibconfsec implements ILibconfsec {
 
   confsecResponseStreamDestroy = jest.fn();
   confsecResponseStreamGetNext = jest.fn();
+  confsecResponseStreamGetNextAsync = jest.fn();
+
+  confsecGetStats = jest.fn();
+  confsecGetCallStats = jest.fn();
+  confsecResetCallStats = jest.fn();
+  confsecSetSlowCallHook = jest.fn();
+  confsecTraceStart = jest.fn();
+  confsecTraceStop = jest.fn();
+  confsecTrackHandles = jest.fn();
+  confsecGetLiveHandles = jest.fn();
 
   reset(): void {
     this.confsecClientCreate.mockReset();
@@ -26,8 +42,14 @@ export class MockLibconfsec implements ILibconfsec {
     this.confsecClientGetMaxCandidateNodes.mockReset();
     this.confsecClientGetDefaultNodeTags.mockReset();
     this.confsecClientSetDefaultNodeTags.mockReset();
+    this.confsecNodeTagSetCreate.mockReset();
     this.confsecClientGetWalletStatus.mockReset();
+    this.confsecClientStartWalletRefresh.mockReset();
+    this.confsecClientReadWallet.mockReset();
+    this.confsecClientRefreshWallet.mockReset();
+    this.confsecClientStopWalletRefresh.mockReset();
     this.confsecClientDoRequest.mockReset();
+    this.confsecClientDoRequestAsync.mockReset();
 
     this.confsecResponseDestroy.mockReset();
     this.confsecResponseGetMetadata.mockReset();
@@ -37,5 +59,15 @@ export class MockLibconfsec implements ILibconfsec {
 
     this.confsecResponseStreamDestroy.mockReset();
     this.confsecResponseStreamGetNext.mockReset();
+    this.confsecResponseStreamGetNextAsync.mockReset();
+
+    this.confsecGetStats.mockReset();
+    this.confsecGetCallStats.mockReset();
+    this.confsecResetCallStats.mockReset();
+    this.confsecSetSlowCallHook.mockReset();
+    this.confsecTraceStart.mockReset();
+    this.confsecTraceStop.mockReset();
+    this.confsecTrackHandles.mockReset();
+    this.confsecGetLiveHandles.mockReset();
   }
 }
@@ -0,0 +1,165 @@
+/**
+ * Limits for a client's pool of request serialization buffers
+ */
+export interface RequestBufferPoolConfig {
+  /** Maximum total size of the idle buffers kept in bytes (default: 4 MiB) */
+  maxBytes?: number;
+  /**
+   * Size in bytes of the largest buffer kept; larger requests get buffers of
+   * their own (default: 1 MiB)
+   */
+  maxBufferBytes?: number;
+}
+
+/**
+ * Request buffer pool counters
+ */
+export interface RequestBufferPoolStats {
+  /** Buffers handed out from the pool */
+  reused: number;
+  /** Buffers allocated because none of the right size was idle */
+  allocated: number;
+  /** Buffers handed out and not yet released */
+  inUse: number;
+  /** Total size of the idle buffers in bytes */
+  idleBytes: number;
+}
+
+// Sizes are rounded up to a power of two, from this size up
+const MIN_BUFFER_BYTES = 1024;
+
+/**
+ * Pool of off-heap buffers for serialized requests, in power-of-two size
+ * classes. Released buffers are kept for reuse while their total size stays
+ * under maxBytes.
+ */
+export class RequestBufferPool {
+  private readonly maxBytes: number;
+  private readonly maxBufferBytes: number;
+  // Idle buffers by size
+  private readonly idle = new Map<number, ArrayBuffer[]>();
+  // Backing stores of the buffers handed out, so that only those are taken
+  // back
+  private readonly inUse = new Set<ArrayBuffer>();
+  private idleBytes = 0;
+  private reused = 0;
+  private allocated = 0;
+
+  constructor({
+    maxBytes = 4 * 1024 * 1024,
+    maxBufferBytes = 1024 * 1024,
+  }: RequestBufferPoolConfig = {}) {
+    this.maxBytes = maxBytes;
+    this.maxBufferBytes = maxBufferBytes;
+  }
+
+  get stats(): RequestBufferPoolStats {
+    return {
+      reused: this.reused,
+      allocated: this.allocated,
+      inUse: this.inUse.size,
+      idleBytes: this.idleBytes,
+    };
+  }
+
+  /**
+   * Get a buffer of at least length bytes, to be given back with release()
+   * once nothing reads it anymore
+   */
+  acquire(length: number): Buffer {
+    const size = sizeClass(length);
+    if (size > this.maxBufferBytes) {
+      this.allocated++;
+      return Buffer.allocUnsafeSlow(length);
+    }
+    let backing = this.idle.get(size)?.pop();
+    if (backing === undefined) {
+      this.allocated++;
+      backing = Buffer.allocUnsafeSlow(size).buffer as ArrayBuffer;
+    } else {
+      this.reused++;
+      this.idleBytes -= size;
+    }
+    this.inUse.add(backing);
+    return Buffer.from(backing);
+  }
+
+  /**
+   * Give back a buffer from acquire(), or any view of it
+   */
+  release(buffer: Buffer): void {
+    const backing = buffer.buffer as ArrayBuffer;
+    if (!this.inUse.delete(backing)) {
+      return;
+    }
+    const size = backing.byteLength;
+    if (this.idleBytes + size > this.maxBytes) {
+      return;
+    }
+    let buffers = this.idle.get(size);
+    if (buffers === undefined) {
+      buffers = [];
+      this.idle.set(size, buffers);
+    }
+    buffers.push(backing);
+    this.idleBytes += size;
+  }
+
+  /**
+   * Drop every idle buffer
+   */
+  clear(): void {
+    this.idle.clear();
+    this.idleBytes = 0;
+  }
+}
+
+function sizeClass(length: number): number {
+  let size = MIN_BUFFER_BYTES;
+  while (size < length) {
+    size *= 2;
+  }
+  return size;
+}
+
+/**
+ * Holds a request's pooled buffer until the request has been submitted and
+ * no attempt to send it is still reading the buffer. Losing hedged attempts
+ * keep running on the thread pool after the request has been submitted.
+ */
+export class BufferLease {
+  readonly buffer: Buffer;
+  private readonly pool: RequestBufferPool | null;
+  private reading = 0;
+  private ended = false;
+
+  constructor(pool: RequestBufferPool | null, buffer: Buffer) {
+    this.pool = pool;
+    this.buffer = buffer;
+  }
+
+  /** Keep the buffer until attempt settles */
+  track<T>(attempt: Promise<T>): Promise<T> {
+    this.reading++;
+    const settle = () => {
+      this.reading--;
+      this.maybeRelease();
+    };
+    attempt.then(settle, settle);
+    return attempt;
+  }
+
+  /** Release the buffer once no tracked attempt is still reading it */
+  end(): void {
+    if (!this.ended) {
+      this.ended = true;
+      this.maybeRelease();
+    }
+  }
+
+  private maybeRelease(): void {
+    if (this.ended && this.reading === 0) {
+      this.pool?.release(this.buffer);
+    }
+  }
+}
@@ -0,0 +1,204 @@
+import { KV } from './response';
+
+/**
+ * Limits for a client's response cache
+ */
+export interface ResponseCacheConfig {
+  /** Maximum total size of cached responses in bytes (default: 64 MiB) */
+  maxBytes?: number;
+  /** Maximum number of cached responses (default: unlimited) */
+  maxEntries?: number;
+  /** Time in ms a cached response stays valid (default: 5 minutes) */
+  ttlMs?: number;
+}
+
+/**
+ * Response cache counters
+ */
+export interface ResponseCacheStats {
+  hits: number;
+  misses: number;
+  evictions: number;
+  expirations: number;
+  entries: number;
+  bytes: number;
+}
+
+// Rough per-entry overhead on top of the body, used for size accounting
+const ENTRY_OVERHEAD_BYTES = 256;
+
+/**
+ * Cached response status, metadata and body
+ */
+export class CachedResponse {
+  readonly status: number;
+  readonly statusText: string;
+  readonly headers: KV[];
+  readonly body: Buffer;
+  readonly size: number;
+  readonly expiresAt: number;
+
+  constructor(
+    status: number,
+    statusText: string,
+    headers: KV[],
+    body: Buffer,
+    expiresAt: number
+  ) {
+    this.status = status;
+    this.statusText = statusText;
+    this.headers = headers;
+    this.body = body;
+    this.expiresAt = expiresAt;
+
+    let size = ENTRY_OVERHEAD_BYTES + body.length + statusText.length;
+    headers.forEach(header => {
+      size += header.key.length + header.value.length;
+    });
+    this.size = size;
+  }
+
+  /**
+   * Create a fetch Response with a copy of the cached body
+   */
+  toResponse(): Response {
+    const headers = new Headers();
+    this.headers.forEach(header => {
+      headers.append(header.key, header.value);
+    });
+    return new Response(new Uint8Array(this.body), {
+      status: this.status,
+      statusText: this.statusText,
+      headers,
+    });
+  }
+}
+
+/**
+ * Size-bounded LRU cache of responses with a fixed time to live. Bodies are
+ * kept in their own off-heap Buffers so they neither count against the V8
+ * heap nor pin shared Buffer pool slabs.
+ */
+export class ResponseCache {
+  private readonly maxBytes: number;
+  private readonly maxEntries: number;
+  private readonly ttlMs: number;
+
+  // Map iteration order doubles as recency order, oldest first
+  private entries = new Map<string, CachedResponse>();
+  private bytes = 0;
+
+  private hits = 0;
+  private misses = 0;
+  private evictions = 0;
+  private expirations = 0;
+
+  constructor({
+    maxBytes = 64 * 1024 * 1024,
+    maxEntries = Infinity,
+    ttlMs = 5 * 60 * 1000,
+  }: ResponseCacheConfig = {}) {
+    this.maxBytes = maxBytes;
+    this.maxEntries = maxEntries;
+    this.ttlMs = ttlMs;
+  }
+
+  /**
+   * Look up a cached response, counting a hit or a miss
+   */
+  get(key: string): CachedResponse | null {
+    const entry = this.entries.get(key);
+    if (entry === undefined) {
+      this.misses++;
+      return null;
+    }
+    if (entry.expiresAt <= Date.now()) {
+      this.remove(key, entry);
+      this.expirations++;
+      this.misses++;
+      return null;
+    }
+
+    // Mark as most recently used
+    this.entries.delete(key);
+    this.entries.set(key, entry);
+    this.hits++;
+    return entry;
+  }
+
+  /**
+   * Cache a response, evicting the least recently used entries to make room.
+   * Responses larger than the whole cache are not stored.
+   */
+  set(
+    key: string,
+    status: number,
+    statusText: string,
+    headers: KV[],
+    chunks: Uint8Array[]
+  ): void {
+    let length = 0;
+    chunks.forEach(chunk => {
+      length += chunk.byteLength;
+    });
+    const body = Buffer.allocUnsafeSlow(length);
+    let offset = 0;
+    chunks.forEach(chunk => {
+      body.set(chunk, offset);
+      offset += chunk.byteLength;
+    });
+
+    const entry = new CachedResponse(
+      status,
+      statusText,
+      headers,
+      body,
+      Date.now() + this.ttlMs
+    );
+    if (entry.size > this.maxBytes || this.maxEntries < 1) {
+      return;
+    }
+
+    const existing = this.entries.get(key);
+    if (existing !== undefined) {
+      this.remove(key, existing);
+    }
+    for (const [oldestKey, oldest] of this.entries) {
+      if (
+        this.bytes + entry.size <= this.maxBytes &&
+        this.entries.size < this.maxEntries
+      ) {
+        break;
+      }
+      this.remove(oldestKey, oldest);
+      this.evictions++;
+    }
+
+    this.entries.set(key, entry);
+    this.bytes += entry.size;
+  }
+
+  /**
+   * Drop every cached response. Counters are preserved.
+   */
+  clear(): void {
+    this.entries.clear();
+    this.bytes = 0;
+  }
+
+  get stats(): ResponseCacheStats {
+    return {
+      hits: this.hits,
+      misses: this.misses,
+      evictions: this.evictions,
+      expirations: this.expirations,
+      entries: this.entries.size,
+      bytes: this.bytes,
+    };
+  }
+
+  private remove(key: string, entry: CachedResponse): void {
+    this.entries.delete(key);
+    this.bytes -= entry.size;
+  }
+}
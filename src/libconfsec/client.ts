@@ -1,8 +1,63 @@
 import { createRequire } from 'module';
 import { Fetch } from 'openai/core';
-import { ILibconfsec, IdentityPolicySource } from './types';
+import {
+  ILibconfsec,
+  IdentityPolicySource,
+  LiveHandle,
+  NativeCallStats,
+  NativeNodeTagSet,
+  NativeStats,
+  SlowCallHook,
+} from './types';
 import { Closeable } from '../closeable';
-import { ConfsecResponse } from './response';
+import {
+  ConfsecResponse,
+  ResponseTimings,
+  TIMINGS_HEADER,
+  formatTimings,
+} from './response';
+import { RequestQueue } from './queue';
+import {
+  ResponseCache,
+  ResponseCacheConfig,
+  ResponseCacheStats,
+} from './cache';
+import { SharedResponse, SingleFlight, requestKey } from './singleflight';
+import {
+  BufferLease,
+  RequestBufferPool,
+  RequestBufferPoolConfig,
+  RequestBufferPoolStats,
+} from './bufferpool';
+import { StaticHeaders } from './headers';
+import { Hedger, HedgingConfig, HedgingStats } from './hedge';
+import { RetryConfig, RetryPolicy, RetryStats, isIdempotent } from './retry';
+import {
+  LatencyHistograms,
+  LatencyHistogramsConfig,
+  ModelLatencySnapshot,
+  TokenCounts,
+  countTokens,
+} from './histogram';
+import {
+  publishError,
+  publishResponse,
+  publishSharedEnd,
+  publishSharedHeaders,
+  publishStart,
+} from './diagnostics';
+import { ChromeTrace, Tracer, TracingConfig } from './trace';
+import { HandleTracker, HandleTrackingConfig } from './leaks';
+import {
+  PrometheusWriter,
+  writeCacheMetrics,
+  writeHedgingMetrics,
+  writeLatencyMetrics,
+  writeNativeCallMetrics,
+  writeNativeMetrics,
+  writeRetryMetrics,
+  writeWalletMetrics,
+} from './metrics';
 
 function getLibConfsec(): ILibconfsec {
   // Create require function that works in both CommonJS and ES modules
@@ -52,10 +107,93 @@ export interface ConfsecClientConfig {
   defaultNodeTags?: string[];
   /** Environment to use */
   env?: string;
+  /** Maximum number of fetch requests in flight at once (default: unlimited) */
+  maxConcurrentRequests?: number;
+  /** Maximum number of fetch requests queued for a slot (default: unlimited) */
+  maxQueueDepth?: number;
+  /** Maximum time in ms a fetch request may wait (default: unlimited) */
+  maxQueueWaitMs?: number;
+  /** Share one response between identical concurrent fetch requests */
+  coalesceRequests?: boolean;
+  /** Cache successful responses to identical fetch requests */
+  responseCache?: ResponseCacheConfig;
+  /** Hedge slow fetch requests with a second request */
+  hedging?: HedgingConfig;
+  /** Retry fetch requests that fail with transient errors (default: off) */
+  retry?: RetryConfig | false;
+  /** Keep latency histograms of fetch requests for each model */
+  latencyHistograms?: LatencyHistogramsConfig;
+  /**
+   * Serialize fetch requests into reusable buffers (false allocates a new
+   * buffer for each request)
+   */
+  requestBufferPool?: RequestBufferPoolConfig | false;
+  /**
+   * Headers sent with every fetch request unless the request sets them, e.g.
+   * user-agent. They are encoded once rather than for each request.
+   */
+  staticHeaders?: Record<string, string>;
+  /**
+   * Refresh the wallet status on a background thread at this interval in ms,
+   * and after every fetch request, so that creditsAvailable, creditsHeld and
+   * metrics() read it without calling into libconfsec
+   */
+  walletRefreshMs?: number;
+  /**
+   * Read the chunks of streamed fetch responses on the thread pool rather
+   * than blocking the event loop until each arrives, recording when each was
+   * received in the response's chunkTimings (default: false)
+   */
+  asyncStreamReads?: boolean;
+  /**
+   * Record the native handles created in the process with their creation
+   * stacks, and report responses and streams left open. Meant for debugging,
+   * since capturing stacks slows down every request.
+   */
+  handleTracking?: HandleTrackingConfig;
   /** Libconfsec implementation to use */
   libconfsec?: ILibconfsec;
 }
 
+/**
+ * Node tags marshalled once by the binding, which can be passed to any
+ * client's setDefaultNodeTags() and requests without being converted again.
+ * Create one with ConfsecClient.createNodeTagSet().
+ */
+export class NodeTagSet {
+  readonly tags: readonly string[];
+  /** Handle to the tags in the binding */
+  readonly native: NativeNodeTagSet;
+
+  constructor(tags: readonly string[], native: NativeNodeTagSet) {
+    this.tags = tags;
+    this.native = native;
+  }
+}
+
+function toNativeTags(
+  tags: string[] | NodeTagSet | undefined
+): string[] | NativeNodeTagSet | undefined {
+  return tags instanceof NodeTagSet ? tags.native : tags;
+}
+
+function toTagList(
+  tags: string[] | NodeTagSet | undefined
+): readonly string[] | undefined {
+  return tags instanceof NodeTagSet ? tags.tags : tags;
+}
+
+/**
+ * Options of a fetch request made through the CONFSEC network
+ */
+export interface ConfsecRequestInit extends RequestInit {
+  /**
+   * Node tags for this request only, on top of the client's default node
+   * tags. Unlike setDefaultNodeTags(), these don't affect concurrent requests.
+   */
+  nodeTags?: string[] | NodeTagSet;
+}
+
 /**
  * Wallet status information
  */
@@ -65,12 +203,38 @@ export interface WalletStatus {
   credits_available: number;
 }
 
+// How long metrics() reuses a wallet status before fetching it again
+const WALLET_STATUS_MAX_AGE_MS = 1000;
+
+// Values of the wallet status copied by confsecClientReadWallet
+const WALLET_CREDITS_AVAILABLE = 0;
+const WALLET_CREDITS_HELD = 1;
+const WALLET_CREDITS_SPENT = 2;
+
 /**
  * Client for making requests via CONFSEC.
  */
 export class ConfsecClient extends Closeable {
   private _handle: number;
   private libconfsec: ILibconfsec;
+  private requestQueue: RequestQueue;
+  private singleFlight: SingleFlight<SharedResponse> | null;
+  private responseCache: ResponseCache | null;
+  private hedger: Hedger<ConfsecResponse> | null;
+  private retryPolicy: RetryPolicy | null;
+  private latencyHistograms: LatencyHistograms | null;
+  private requestBufferPool: RequestBufferPool | null;
+  private staticHeaders: StaticHeaders;
+  private tracer: Tracer | null = null;
+  private handleTracker: HandleTracker | null = null;
+  private asyncStreamReads: boolean;
+  // Receives the wallet status refreshed in the background
+  private walletSnapshot: Float64Array | null = null;
+  private defaultNodeTags: string[] | null = null;
+  private walletStatus: { status: WalletStatus; fetchedAt: number } | null =
+    null;
+  private walletStatusErrors = 0;
+  private pendingAsyncRequests = 0;
 
   constructor({
     apiUrl,
@@ -84,10 +248,43 @@ export class ConfsecClient extends Closeable {
     maxCandidateNodes = 5,
     defaultNodeTags = [],
     env,
+    maxConcurrentRequests = Infinity,
+    maxQueueDepth = Infinity,
+    maxQueueWaitMs = Infinity,
+    coalesceRequests = false,
+    responseCache,
+    hedging,
+    retry,
+    latencyHistograms,
+    requestBufferPool = {},
+    staticHeaders,
+    walletRefreshMs,
+    asyncStreamReads = false,
+    handleTracking,
     libconfsec = undefined,
   }: ConfsecClientConfig) {
     super();
     this.libconfsec = libconfsec || getLibConfsec();
+    this.requestQueue = new RequestQueue({
+      maxConcurrentRequests,
+      maxQueueDepth,
+      maxQueueWaitMs,
+    });
+    this.singleFlight = coalesceRequests ? new SingleFlight() : null;
+    this.responseCache = responseCache
+      ? new ResponseCache(responseCache)
+      : null;
+    this.hedger = hedging ? new Hedger(hedging) : null;
+    this.retryPolicy = retry ? new RetryPolicy(retry) : null;
+    this.latencyHistograms = latencyHistograms
+      ? new LatencyHistograms(latencyHistograms)
+      : null;
+    this.requestBufferPool =
+      requestBufferPool === false
+        ? null
+        : new RequestBufferPool(requestBufferPool);
+    this.staticHeaders = new StaticHeaders(staticHeaders);
+    this.asyncStreamReads = asyncStreamReads;
 
     this._handle = this.libconfsec.confsecClientCreate(
       apiUrl,
@@ -102,6 +299,16 @@ export class ConfsecClient extends Closeable {
       defaultNodeTags,
       env || 'prod'
     );
+    if (walletRefreshMs !== undefined) {
+      this.libconfsec.confsecClientStartWalletRefresh(
+        this._handle,
+        walletRefreshMs
+      );
+      this.walletSnapshot = new Float64Array(3);
+    }
+    if (handleTracking) {
+      this.handleTracker = new HandleTracker(this.libconfsec, handleTracking);
+    }
   }
 
   /**
@@ -128,17 +335,50 @@ export class ConfsecClient extends Closeable {
   }
 
   /**
-   * Get the current default node tags
+   * Get the current default node tags. They are only fetched from libconfsec
+   * again after setDefaultNodeTags().
    */
   getDefaultNodeTags(): string[] {
-    return this.libconfsec.confsecClientGetDefaultNodeTags(this._handle);
+    if (this.defaultNodeTags === null) {
+      this.defaultNodeTags = this.libconfsec.confsecClientGetDefaultNodeTags(
+        this._handle
+      );
+    }
+    return [...this.defaultNodeTags];
   }
 
   /**
    * Set new default node tags
    */
-  setDefaultNodeTags(tags: string[]): void {
-    this.libconfsec.confsecClientSetDefaultNodeTags(this._handle, tags);
+  setDefaultNodeTags(tags: string[] | NodeTagSet): void {
+    this.libconfsec.confsecClientSetDefaultNodeTags(
+      this._handle,
+      tags instanceof NodeTagSet ? tags.native : tags
+    );
+    this.defaultNodeTags = null;
+  }
+
+  /**
+   * Get the headers sent with every fetch request
+   */
+  getStaticHeaders(): Record<string, string> {
+    return this.staticHeaders.headers;
+  }
+
+  /**
+   * Set new headers to send with every fetch request
+   */
+  setStaticHeaders(headers: Record<string, string>): void {
+    this.staticHeaders = new StaticHeaders(headers);
+  }
+
+  /**
+   * Marshal node tags once, for repeated use as default or per-request node
+   * tags with any client
+   */
+  createNodeTagSet(tags: string[]): NodeTagSet {
+    const native = this.libconfsec.confsecNodeTagSetCreate(tags);
+    return new NodeTagSet(Object.freeze([...tags]), native);
   }
 
   /**
@@ -149,76 +389,583 @@ export class ConfsecClient extends Closeable {
     return <WalletStatus>JSON.parse(raw);
   }
 
+  /**
+   * Credits available in the wallet. With walletRefreshMs set, this reads the
+   * last status refreshed in the background without calling into libconfsec;
+   * otherwise, or until the first refresh, it fetches the wallet status.
+   */
+  get creditsAvailable(): number {
+    const snapshot = this.readWalletSnapshot();
+    if (snapshot) {
+      return snapshot[WALLET_CREDITS_AVAILABLE];
+    }
+    return this.getWalletStatus().credits_available;
+  }
+
+  /**
+   * Credits held for requests in progress, read like creditsAvailable
+   */
+  get creditsHeld(): number {
+    const snapshot = this.readWalletSnapshot();
+    if (snapshot) {
+      return snapshot[WALLET_CREDITS_HELD];
+    }
+    return this.getWalletStatus().credits_held;
+  }
+
   /**
    * Send an HTTP request through the CONFSEC network
    * @param request - Raw HTTP request string or buffer
+   * @param nodeTags - Node tags for this request only, on top of the default
+   * node tags
    * @returns ConfsecResponse object
    */
-  doRequest(request: string | Buffer): ConfsecResponse {
+  doRequest(
+    request: string | Buffer,
+    nodeTags?: string[] | NodeTagSet
+  ): ConfsecResponse {
+    const submitted = performance.now();
     const responseHandle = this.libconfsec.confsecClientDoRequest(
       this._handle,
-      request
+      request,
+      toNativeTags(nodeTags)
+    );
+    return new ConfsecResponse(this.libconfsec, responseHandle, {
+      submitted,
+      headersReceived: performance.now(),
+    });
+  }
+
+  /**
+   * Send an HTTP request through the CONFSEC network without blocking the
+   * event loop while waiting for the response
+   * @param request - Raw HTTP request string or buffer
+   * @param nodeTags - Node tags for this request only, on top of the default
+   * node tags
+   * @returns Promise resolving to a ConfsecResponse object
+   */
+  async doRequestAsync(
+    request: string | Buffer,
+    nodeTags?: string[] | NodeTagSet
+  ): Promise<ConfsecResponse> {
+    this.pendingAsyncRequests++;
+    const submitted = performance.now();
+    let responseHandle: number;
+    try {
+      responseHandle = await this.libconfsec.confsecClientDoRequestAsync(
+        this._handle,
+        request,
+        toNativeTags(nodeTags)
+      );
+    } catch (e) {
+      this.settleAsyncRequest();
+      throw e;
+    }
+
+    const response = new ConfsecResponse(this.libconfsec, responseHandle, {
+      submitted,
+      headersReceived: performance.now(),
+    });
+    if (this.isClosed) {
+      response.close();
+    }
+    this.settleAsyncRequest();
+    if (this.isClosed) {
+      throw new Error('Client is closed');
+    }
+    return response;
+  }
+
+  /**
+   * Get the number of fetch requests currently in flight
+   */
+  getInFlightRequests(): number {
+    return this.requestQueue.inFlight;
+  }
+
+  /**
+   * Get the number of fetch requests waiting for a slot
+   */
+  getQueueDepth(): number {
+    return this.requestQueue.depth;
+  }
+
+  /**
+   * Get the number of fetch requests that were served by attaching to an
+   * identical request already in flight
+   */
+  getCoalescedRequests(): number {
+    return this.singleFlight?.coalesced ?? 0;
+  }
+
+  /**
+   * Get the response cache counters, or null if caching is disabled
+   */
+  getCacheStats(): ResponseCacheStats | null {
+    return this.responseCache?.stats ?? null;
+  }
+
+  /**
+   * Drop every cached response
+   */
+  clearCache(): void {
+    this.responseCache?.clear();
+  }
+
+  /**
+   * Get the hedging counters, or null if hedging is disabled
+   */
+  getHedgingStats(): HedgingStats | null {
+    return this.hedger?.stats ?? null;
+  }
+
+  /**
+   * Get the retry counters, or null if retries are disabled
+   */
+  getRetryStats(): RetryStats | null {
+    return this.retryPolicy?.stats ?? null;
+  }
+
+  /**
+   * Get the request buffer pool counters, or null if the pool is disabled
+   */
+  getRequestBufferPoolStats(): RequestBufferPoolStats | null {
+    return this.requestBufferPool?.stats ?? null;
+  }
+
+  /**
+   * Get the latency distributions of fetch requests for each model, or null
+   * if latency histograms are disabled
+   */
+  getLatencyHistograms(): Record<string, ModelLatencySnapshot> | null {
+    return this.latencyHistograms?.snapshot() ?? null;
+  }
+
+  /**
+   * Drop every value recorded in the latency histograms
+   */
+  resetLatencyHistograms(): void {
+    this.latencyHistograms?.reset();
+  }
+
+  /**
+   * Get the process-wide counters maintained by the native binding, covering
+   * every client in the process. The in-flight request and byte gauges only
+   * cover asynchronous requests, such as those of hedged clients, since a
+   * synchronous request completes before the JS thread can read them.
+   */
+  getStats(): NativeStats {
+    return this.libconfsec.confsecGetStats();
+  }
+
+  /**
+   * Get the wall time spent in each synchronous native function, keyed by
+   * function name. The JS thread is blocked for the whole of these calls.
+   * Like getStats, this covers every client in the process.
+   */
+  getNativeCallStats(): Record<string, NativeCallStats> {
+    return this.libconfsec.confsecGetCallStats();
+  }
+
+  /**
+   * Reset the stats returned by getNativeCallStats, for every client in the
+   * process
+   */
+  resetNativeCallStats(): void {
+    this.libconfsec.confsecResetCallStats();
+  }
+
+  /**
+   * Call hook after any synchronous native call in the process blocks the JS
+   * thread for at least thresholdMs. The hook runs on a later turn of the
+   * event loop, must not throw, and replaces any hook set before, by any
+   * client; pass null to remove it.
+   */
+  setSlowCallHook(thresholdMs: number, hook: SlowCallHook | null): void {
+    if (hook !== null && !(thresholdMs > 0)) {
+      throw new Error('thresholdMs must be positive');
+    }
+    this.libconfsec.confsecSetSlowCallHook(thresholdMs, hook);
+  }
+
+  /**
+   * Get the native handles of the process that have not been destroyed, with
+   * their age and the JS stack that created them. Handles are only recorded
+   * while a client with handleTracking enabled is open.
+   */
+  getLiveHandles(): LiveHandle[] {
+    return this.libconfsec.confsecGetLiveHandles();
+  }
+
+  /**
+   * Start recording a trace of native calls, thread pool work and the phases
+   * of fetch requests. Native work is traced across the process, so only one
+   * trace can be recorded at a time.
+   */
+  startTracing(config: TracingConfig = {}): void {
+    if (this.tracer) {
+      throw new Error('Tracing already started');
+    }
+    const tracer = new Tracer(this.libconfsec, config);
+    tracer.start();
+    this.tracer = tracer;
+  }
+
+  /**
+   * Stop recording the trace started by startTracing, and return it in the
+   * Chrome trace event format. Serialized to JSON, it can be loaded in
+   * Perfetto or chrome://tracing.
+   */
+  stopTracing(): ChromeTrace {
+    if (!this.tracer) {
+      throw new Error('Tracing not started');
+    }
+    const tracer = this.tracer;
+    this.tracer = null;
+    return tracer.stop();
+  }
+
+  /**
+   * Render the client's metrics in the Prometheus text exposition format. The
+   * wallet status is fetched at most once per second, so this is cheap enough
+   * to scrape frequently. If fetching it fails, the wallet gauges are left out
+   * and counted in confsec_wallet_status_errors_total.
+   */
+  metrics(): string {
+    const writer = new PrometheusWriter();
+    writeWalletMetrics(
+      writer,
+      this.getCachedWalletStatus(),
+      this.walletStatusErrors
     );
-    return new ConfsecResponse(this.libconfsec, responseHandle);
+    writer
+      .metric(
+        'confsec_fetch_requests_in_flight',
+        'gauge',
+        'Fetch requests in flight',
+        this.requestQueue.inFlight
+      )
+      .metric(
+        'confsec_fetch_requests_queued',
+        'gauge',
+        'Fetch requests waiting for a slot',
+        this.requestQueue.depth
+      );
+    if (this.singleFlight) {
+      writer.metric(
+        'confsec_fetch_coalesced_total',
+        'counter',
+        'Fetch requests served by an identical request in flight',
+        this.singleFlight.coalesced
+      );
+    }
+    writeNativeMetrics(writer, this.getStats());
+    writeNativeCallMetrics(writer, this.getNativeCallStats());
+    if (this.responseCache) {
+      writeCacheMetrics(writer, this.responseCache.stats);
+    }
+    if (this.hedger) {
+      writeHedgingMetrics(writer, this.hedger.stats);
+    }
+    if (this.retryPolicy) {
+      writeRetryMetrics(writer, this.retryPolicy.stats);
+    }
+    if (this.latencyHistograms) {
+      writeLatencyMetrics(writer, this.latencyHistograms);
+    }
+    return writer.toString();
   }
 
   /**
-   * Get a Fetch function that can be used to make requests through the CONFSEC network
+   * Get a Fetch function that can be used to make requests through the CONFSEC
+   * network. If the client's queue limits are exceeded, the returned promise
+   * rejects with a ConfsecOverloadError.
    */
   getConfsecFetch(): Fetch {
     const confsecFetch: Fetch = async (
       url: RequestInfo,
       init?: RequestInit
     ): Promise<Response> => {
-      return new Promise(resolve => {
-        let request: Request;
-        if (typeof url === 'string') {
-          request = new Request(url, init);
-        } else {
-          request = url;
-        }
+      const timings: ResponseTimings = { queued: performance.now() };
+      let request: Request;
+      if (typeof url === 'string') {
+        request = new Request(url, init);
+      } else {
+        request = url;
+      }
 
-        const response = request.arrayBuffer().then(requestBody => {
-          preProcessRequest(request, requestBody);
-          const rawRequest = prepareRequest(request, requestBody);
-          const confsecResponse = this.doRequest(rawRequest);
+      const nodeTags = (init as ConfsecRequestInit | undefined)?.nodeTags;
 
-          const responseBody = confsecResponse.isStreaming
-            ? confsecResponse.getStream().toReadableStream()
-            : new Uint8Array(confsecResponse.body);
-
-          const responseHeaders = new Headers();
-          confsecResponse.metadata.headers.forEach(header => {
-            responseHeaders.append(header.key, header.value);
-          });
+      publishStart(request, timings);
+      try {
+        return await this.fetchRequest(request, timings, nodeTags);
+      } catch (e) {
+        publishError(request, e, timings);
+        throw e;
+      }
+    };
+    return confsecFetch;
+  }
 
-          const httpResponse = new Response(responseBody, {
-            status: confsecResponse.metadata.status_code,
-            statusText: confsecResponse.metadata.reason_phrase,
-            headers: responseHeaders,
-          });
+  private async fetchRequest(
+    request: Request,
+    timings: ResponseTimings,
+    nodeTags: string[] | NodeTagSet | undefined
+  ): Promise<Response> {
+    const requestBody = await request.arrayBuffer();
+    preProcessRequest(request, requestBody);
+    const lease = new BufferLease(
+      this.requestBufferPool,
+      prepareRequest(
+        request,
+        requestBody,
+        this.requestBufferPool ?? undefined,
+        this.staticHeaders
+      )
+    );
+    timings.serialized = performance.now();
+    try {
+      return await this.fetchSerializedRequest(
+        request,
+        lease,
+        timings,
+        nodeTags
+      );
+    } finally {
+      lease.end();
+    }
+  }
 
-          if (!confsecResponse.isStreaming) {
-            confsecResponse.close();
-          }
+  private async fetchSerializedRequest(
+    request: Request,
+    lease: BufferLease,
+    timings: ResponseTimings,
+    nodeTags: string[] | NodeTagSet | undefined
+  ): Promise<Response> {
+    const singleFlight = this.singleFlight;
+    const responseCache = isCacheable(request) ? this.responseCache : null;
+    if (singleFlight === null && responseCache === null) {
+      return toFetchResponse(
+        await this.submitRequest(request, lease, timings, nodeTags)
+      );
+    }
 
-          return httpResponse;
-        });
+    const key = requestKey(lease.buffer, toTagList(nodeTags));
+    const cached = responseCache?.get(key);
+    if (cached) {
+      publishSharedHeaders(request, 'cache', timings);
+      publishSharedEnd(request, 'cache', timings);
+      return cached.toResponse();
+    }
 
-        resolve(response);
+    let leader = false;
+    const submit = async () => {
+      leader = true;
+      const confsecResponse = await this.submitRequest(
+        request,
+        lease,
+        timings,
+        nodeTags
+      );
+      const sharedResponse = SharedResponse.from(confsecResponse);
+      const { status, statusText, headers, body } = sharedResponse;
+      body.onComplete(() => {
+        singleFlight?.forget(key);
+        const chunks = body.chunksIfDone;
+        if (responseCache && chunks && isSuccess(status)) {
+          // Timings describe the original request, not the cache hits
+          const cachedHeaders = headers.filter(
+            header => header.key !== TIMINGS_HEADER
+          );
+          responseCache.set(key, status, statusText, cachedHeaders, chunks);
+        }
       });
+      return sharedResponse;
     };
-    return confsecFetch;
+    const flight = singleFlight ? singleFlight.do(key, submit) : submit();
+    const sharedResponse = await flight;
+    if (!leader) {
+      publishSharedHeaders(request, 'coalesced', timings);
+      sharedResponse.body.onComplete(() =>
+        publishSharedEnd(request, 'coalesced', timings)
+      );
+    }
+    return sharedResponse.toResponse();
+  }
+
+  /**
+   * Submit a serialized request once a slot is available, retrying transient
+   * failures. The slot is held until the returned response has been closed.
+   * The timings of the fetch call are merged into the response's, which is
+   * then recorded in the latency histograms and diagnostics channels.
+   */
+  private async submitRequest(
+    request: Request,
+    lease: BufferLease,
+    timings: ResponseTimings,
+    nodeTags: string[] | NodeTagSet | undefined
+  ): Promise<ConfsecResponse> {
+    const release = await this.requestQueue.acquire();
+    const send = () =>
+      this.hedger
+        ? this.hedger.send(() =>
+            lease.track(this.doRequestAsync(lease.buffer, nodeTags))
+          )
+        : new Promise<ConfsecResponse>(resolve => {
+            resolve(this.doRequest(lease.buffer, nodeTags));
+          });
+    let confsecResponse: ConfsecResponse;
+    try {
+      confsecResponse = this.retryPolicy
+        ? await this.retryPolicy.send(send, isIdempotent(request))
+        : await send();
+    } catch (e) {
+      release();
+      throw e;
+    }
+    Object.assign(confsecResponse.timings, timings);
+    confsecResponse.asyncStreamReads = this.asyncStreamReads;
+    confsecResponse.onClose(release);
+    if (this.walletSnapshot) {
+      confsecResponse.onClose(() =>
+        this.libconfsec.confsecClientRefreshWallet(this._handle)
+      );
+    }
+    const model = this.latencyHistograms
+      ? getModelTag(request, toTagList(nodeTags))
+      : null;
+    if (this.latencyHistograms && model !== null) {
+      this.trackLatency(this.latencyHistograms, confsecResponse, model);
+    }
+    publishResponse(request, confsecResponse);
+    return confsecResponse;
+  }
+
+  /**
+   * Copy the wallet status refreshed in the background into walletSnapshot,
+   * or return null if there is none yet
+   */
+  private readWalletSnapshot(): Float64Array | null {
+    const snapshot = this.walletSnapshot;
+    if (
+      snapshot === null ||
+      !this.libconfsec.confsecClientReadWallet(this._handle, snapshot)
+    ) {
+      return null;
+    }
+    return snapshot;
+  }
+
+  // Get the wallet status for metrics, or null if it couldn't be fetched
+  private getCachedWalletStatus(): WalletStatus | null {
+    const snapshot = this.readWalletSnapshot();
+    if (snapshot) {
+      return {
+        credits_spent: snapshot[WALLET_CREDITS_SPENT],
+        credits_held: snapshot[WALLET_CREDITS_HELD],
+        credits_available: snapshot[WALLET_CREDITS_AVAILABLE],
+      };
+    }
+    const now = performance.now();
+    if (
+      this.walletStatus === null ||
+      now - this.walletStatus.fetchedAt > WALLET_STATUS_MAX_AGE_MS
+    ) {
+      try {
+        this.walletStatus = { status: this.getWalletStatus(), fetchedAt: now };
+      } catch {
+        this.walletStatusErrors++;
+        return null;
+      }
+    }
+    return this.walletStatus.status;
+  }
+
+  private trackLatency(
+    histograms: LatencyHistograms,
+    confsecResponse: ConfsecResponse,
+    model: string
+  ): void {
+    const tokens: TokenCounts = { events: 0, completionTokens: null };
+    confsecResponse.onChunk(chunk => countTokens(chunk, tokens));
+    confsecResponse.onClose(() => {
+      histograms.record(model, confsecResponse.timings, tokens);
+    });
   }
 
   /**
    * Close the client and free resources
    */
   protected doClose(): void {
-    this.libconfsec.confsecClientDestroy(this._handle);
+    this.requestQueue.close();
+    if (this.tracer) {
+      this.stopTracing();
+    }
+    this.handleTracker?.close();
+    this.requestBufferPool?.clear();
+    if (this.walletSnapshot) {
+      // The refresh thread uses the client until it has stopped
+      this.pendingAsyncRequests++;
+      const settle = () => this.settleAsyncRequest();
+      this.libconfsec
+        .confsecClientStopWalletRefresh(this._handle)
+        .then(settle, settle);
+    }
+    // Requests still running on the thread pool, and the wallet refresh
+    // thread, use the client, so destroying it is deferred until they have
+    // finished
+    if (this.pendingAsyncRequests === 0) {
+      this.libconfsec.confsecClientDestroy(this._handle);
+    }
+  }
+
+  private settleAsyncRequest(): void {
+    this.pendingAsyncRequests--;
+    if (this.isClosed && this.pendingAsyncRequests === 0) {
+      this.libconfsec.confsecClientDestroy(this._handle);
+    }
   }
 }
 
+function isCacheable(request: Request): boolean {
+  const cacheControl = request.headers.get('cache-control');
+  return !cacheControl || !/no-store|no-cache/i.test(cacheControl);
+}
+
+function isSuccess(status: number): boolean {
+  return status >= 200 && status < 300;
+}
+
+function toFetchResponse(confsecResponse: ConfsecResponse): Response {
+  let httpResponse: Response;
+  try {
+    const responseBody = confsecResponse.isStreaming
+      ? confsecResponse.getStream().toReadableStream()
+      : new Uint8Array(confsecResponse.body);
+
+    const responseHeaders = new Headers();
+    confsecResponse.metadata.headers.forEach(header => {
+      responseHeaders.append(header.key, header.value);
+    });
+    responseHeaders.set(TIMINGS_HEADER, formatTimings(confsecResponse.timings));
+
+    httpResponse = new Response(responseBody, {
+      status: confsecResponse.metadata.status_code,
+      statusText: confsecResponse.metadata.reason_phrase,
+      headers: responseHeaders,
+    });
+  } catch (e) {
+    confsecResponse.close();
+    throw e;
+  }
+
+  if (!confsecResponse.isStreaming) {
+    confsecResponse.close();
+  }
+
+  return httpResponse;
+}
+
 const OPENAI_COMPLETIONS_PATH = '/v1/completions';
 const OPENAI_CHAT_COMPLETIONS_PATH = '/v1/chat/completions';
 
@@ -234,6 +981,20 @@ export function preProcessRequest(
   }
 }
 
+/**
+ * Get the model named by a request's node tags, if any, looking at its
+ * x-confsec-node-tags header before its per-request tags
+ */
+export function getModelTag(
+  request: Request,
+  nodeTags: readonly string[] = []
+): string | null {
+  const header = request.headers.get('x-confsec-node-tags');
+  const tags = header === null ? nodeTags : [...header.split(','), ...nodeTags];
+  const modelTag = tags.find(tag => tag.startsWith('model='));
+  return modelTag === undefined ? null : modelTag.slice('model='.length);
+}
+
 export function maybeAddModelTag(
   request: Request,
   body: ArrayBuffer | null
@@ -271,39 +1032,52 @@ export function maybeAddModelTag(
   request.headers.set('x-confsec-node-tags', header);
 }
 
+/**
+ * Serialize a request, into a buffer from pool if given, which must be
+ * released to it once the request has been sent. The host line and static
+ * headers are copied from their encoded block if given.
+ */
 export function prepareRequest(
   request: Request,
-  body: ArrayBuffer | null
+  body: ArrayBuffer | null,
+  pool?: RequestBufferPool,
+  staticHeaders?: StaticHeaders
 ): Buffer {
-  const encoder = new TextEncoder();
-  const requestComponents: Uint8Array[] = [];
-
   const url = new URL(request.url);
   // Request line
-  requestComponents.push(
-    encoder.encode(`${request.method} ${url.pathname} HTTP/1.1\r\n`)
-  );
+  const requestLine = `${request.method} ${url.pathname} HTTP/1.1\r\n`;
+  const block = staticHeaders?.encode(url.host, request.headers);
+  let head = '';
   // Manually insert host header if it's not already present
-  if (!request.headers.has('host')) {
-    requestComponents.push(encoder.encode(`host: ${url.host}\r\n`));
+  if (block === undefined && !request.headers.has('host')) {
+    head += `host: ${url.host}\r\n`;
   }
   // Rest of headers
   request.headers.forEach((value, name) => {
-    requestComponents.push(encoder.encode(`${name}: ${value}\r\n`));
+    if (!staticHeaders?.covers(name, value)) {
+      head += `${name}: ${value}\r\n`;
+    }
   });
   // Manually insert content-length header if it's not already present
   if (body != null && !request.headers.has('content-length')) {
-    requestComponents.push(
-      encoder.encode(`content-length: ${body.byteLength}\r\n`)
-    );
+    head += `content-length: ${body.byteLength}\r\n`;
   }
   // End of headers
-  requestComponents.push(encoder.encode('\r\n'));
+  head += '\r\n';
 
+  const requestLineLength = Buffer.byteLength(requestLine);
+  const blockLength = block?.length ?? 0;
+  const headLength = Buffer.byteLength(head);
+  const bodyOffset = requestLineLength + blockLength + headLength;
+  const length = bodyOffset + (body?.byteLength ?? 0);
+  const buffer = pool ? pool.acquire(length) : Buffer.allocUnsafe(length);
+  buffer.write(requestLine, 0);
+  block?.copy(buffer, requestLineLength);
+  buffer.write(head, requestLineLength + blockLength);
   // Body
   if (body != null) {
-    requestComponents.push(new Uint8Array(body));
+    buffer.set(new Uint8Array(body), bodyOffset);
   }
 
-  return Buffer.concat(requestComponents);
+  return buffer.subarray(0, length);
 }
@@ -0,0 +1,190 @@
+import { channel } from 'diagnostics_channel';
+import { ConfsecResponse, ResponseTimings } from './response';
+
+/**
+ * Published when a fetch request is made
+ */
+export interface RequestStartMessage {
+  request: Request;
+  timings: ResponseTimings;
+}
+
+/**
+ * Where the response to a fetch request came from: libconfsec, the response
+ * cache, or an identical request in flight
+ */
+export type ResponseSource = 'network' | 'cache' | 'coalesced';
+
+/**
+ * Published when libconfsec returns the response to a fetch request, or when
+ * the response is served from the cache or by an identical request in flight.
+ * Subscribers may read the response's metadata but must not read its body.
+ */
+export interface RequestHeadersMessage {
+  request: Request;
+  /** The response, or null unless source is 'network' */
+  response: ConfsecResponse | null;
+  source: ResponseSource;
+  timings: ResponseTimings;
+}
+
+/**
+ * Published for every chunk read from a response's stream, or with the body
+ * of a non-streaming response
+ */
+export interface RequestChunkMessage {
+  request: Request;
+  response: ConfsecResponse;
+  chunk: Buffer;
+  timings: ResponseTimings;
+}
+
+/**
+ * Published when the response to a fetch request is closed. Responses served
+ * from the cache end with their headers; those served by an identical request
+ * in flight end once its body has been read.
+ */
+export interface RequestEndMessage {
+  request: Request;
+  /** The response, or null unless source is 'network' */
+  response: ConfsecResponse | null;
+  source: ResponseSource;
+  timings: ResponseTimings;
+}
+
+/**
+ * Published when a fetch request fails, or reading its response fails
+ */
+export interface RequestErrorMessage {
+  request: Request;
+  error: unknown;
+  timings: ResponseTimings;
+}
+
+/**
+ * Names of the diagnostics channels on which fetch requests are published.
+ * Messages carry the request's timings object, which keeps being updated as
+ * the request progresses.
+ */
+export const DIAGNOSTICS_CHANNELS = {
+  start: 'confsec:request:start',
+  headers: 'confsec:request:headers',
+  chunk: 'confsec:request:chunk',
+  end: 'confsec:request:end',
+  error: 'confsec:request:error',
+} as const;
+
+const startChannel = channel(DIAGNOSTICS_CHANNELS.start);
+const headersChannel = channel(DIAGNOSTICS_CHANNELS.headers);
+const chunkChannel = channel(DIAGNOSTICS_CHANNELS.chunk);
+const endChannel = channel(DIAGNOSTICS_CHANNELS.end);
+const errorChannel = channel(DIAGNOSTICS_CHANNELS.error);
+
+export function publishStart(
+  request: Request,
+  timings: ResponseTimings
+): void {
+  if (startChannel.hasSubscribers) {
+    const message: RequestStartMessage = { request, timings };
+    startChannel.publish(message);
+  }
+}
+
+export function publishError(
+  request: Request,
+  error: unknown,
+  timings: ResponseTimings
+): void {
+  if (errorChannel.hasSubscribers) {
+    const message: RequestErrorMessage = { request, error, timings };
+    errorChannel.publish(message);
+  }
+}
+
+/**
+ * Publish the headers of a response, and subscribe to its chunks, closing and
+ * errors for channels that currently have subscribers
+ */
+export function publishResponse(
+  request: Request,
+  response: ConfsecResponse
+): void {
+  const timings = response.timings;
+  const source = 'network';
+  if (headersChannel.hasSubscribers) {
+    const message: RequestHeadersMessage = {
+      request,
+      response,
+      source,
+      timings,
+    };
+    headersChannel.publish(message);
+  }
+  if (chunkChannel.hasSubscribers) {
+    response.onChunk(chunk => {
+      const message: RequestChunkMessage = {
+        request,
+        response,
+        chunk,
+        timings,
+      };
+      chunkChannel.publish(message);
+    });
+  }
+  if (endChannel.hasSubscribers) {
+    response.onClose(() => {
+      const message: RequestEndMessage = {
+        request,
+        response,
+        source,
+        timings,
+      };
+      endChannel.publish(message);
+    });
+  }
+  if (errorChannel.hasSubscribers) {
+    response.onError(error => publishError(request, error, timings));
+  }
+}
+
+/**
+ * Publish the headers of a response not returned by libconfsec for this
+ * request, recording when they were received
+ */
+export function publishSharedHeaders(
+  request: Request,
+  source: ResponseSource,
+  timings: ResponseTimings
+): void {
+  timings.headersReceived = performance.now();
+  if (headersChannel.hasSubscribers) {
+    const message: RequestHeadersMessage = {
+      request,
+      response: null,
+      source,
+      timings,
+    };
+    headersChannel.publish(message);
+  }
+}
+
+/**
+ * Publish the end of a response not returned by libconfsec for this request,
+ * recording when it was closed
+ */
+export function publishSharedEnd(
+  request: Request,
+  source: ResponseSource,
+  timings: ResponseTimings
+): void {
+  timings.closed = performance.now();
+  if (endChannel.hasSubscribers) {
+    const message: RequestEndMessage = {
+      request,
+      response: null,
+      source,
+      timings,
+    };
+    endChannel.publish(message);
+  }
+}
@@ -0,0 +1,67 @@
+/**
+ * Reason a request was rejected by the client's admission queue
+ */
+export type OverloadReason = 'queue_full' | 'queue_timeout';
+
+/**
+ * Raised when the client is saturated and refuses to accept more work. Callers
+ * can catch this to redirect traffic elsewhere instead of waiting.
+ */
+export class ConfsecOverloadError extends Error {
+  readonly code = 'CONFSEC_OVERLOADED';
+  readonly reason: OverloadReason;
+
+  constructor(reason: OverloadReason, message: string) {
+    super(message);
+    this.name = 'ConfsecOverloadError';
+    this.reason = reason;
+  }
+}
+
+/**
+ * Classification of a libconfsec failure, set as the `code` property of errors
+ * raised by the native binding
+ */
+export type ConfsecErrorCode =
+  | 'CONFSEC_NO_NODES'
+  | 'CONFSEC_RATE_LIMITED'
+  | 'CONFSEC_UNAVAILABLE'
+  | 'CONFSEC_TIMEOUT'
+  | 'CONFSEC_NETWORK'
+  | 'CONFSEC_INSUFFICIENT_CREDITS'
+  | 'CONFSEC_AUTH'
+  | 'CONFSEC_POLICY'
+  | 'CONFSEC_INVALID_REQUEST'
+  | 'CONFSEC_UNKNOWN';
+
+/**
+ * Error raised by the native binding
+ */
+export interface ConfsecNativeError extends Error {
+  code: ConfsecErrorCode;
+  /** Whether the same request may succeed if sent again */
+  transient: boolean;
+}
+
+function isNativeError(error: unknown): error is ConfsecNativeError {
+  return (
+    error instanceof Error &&
+    typeof (error as Partial<ConfsecNativeError>).code === 'string' &&
+    typeof (error as Partial<ConfsecNativeError>).transient === 'boolean'
+  );
+}
+
+/**
+ * Get the classification of an error raised by the native binding, or null if
+ * the error did not come from libconfsec
+ */
+export function getErrorCode(error: unknown): ConfsecErrorCode | null {
+  return isNativeError(error) ? error.code : null;
+}
+
+/**
+ * Whether an error is a libconfsec failure that may succeed if retried
+ */
+export function isTransientError(error: unknown): boolean {
+  return isNativeError(error) && error.transient;
+}
@@ -0,0 +1,71 @@
+/**
+ * Header lines sent with every fetch request of a client, together with the
+ * host line, encoded once and copied into each serialized request. Headers
+ * set on a request take precedence unless they carry the same value, in which
+ * case the encoded line is reused and the request's copy is left out.
+ */
+export class StaticHeaders {
+  // Encoded line and value of each header, keyed by lowercase name
+  private readonly lines = new Map<string, { value: string; line: Buffer }>();
+  // Encoded block for the last host seen
+  private host: string | null = null;
+  private hostLine: Buffer = Buffer.alloc(0);
+  private block: Buffer = Buffer.alloc(0);
+
+  constructor(headers: Record<string, string> = {}) {
+    // Validates and lowercases the names
+    new Headers(headers).forEach((value, name) => {
+      this.lines.set(name, {
+        value,
+        line: Buffer.from(`${name}: ${value}\r\n`),
+      });
+    });
+  }
+
+  get headers(): Record<string, string> {
+    return Object.fromEntries(
+      Array.from(this.lines, ([name, { value }]) => [name, value])
+    );
+  }
+
+  /**
+   * Whether the request header name: value is already part of the encoded
+   * block and should not be written again
+   */
+  covers(name: string, value: string): boolean {
+    return this.lines.get(name)?.value === value;
+  }
+
+  /**
+   * Get the encoded host and static header lines of a request to host, less
+   * those set to other values in headers
+   */
+  encode(host: string, headers: Headers): Buffer {
+    if (host !== this.host) {
+      this.hostLine = Buffer.from(`host: ${host}\r\n`);
+      this.block = Buffer.concat([
+        this.hostLine,
+        ...Array.from(this.lines.values(), ({ line }) => line),
+      ]);
+      this.host = host;
+    }
+    const keeps = (name: string, value: string) => {
+      const requestValue = headers.get(name);
+      return requestValue === null || requestValue === value;
+    };
+    let complete = !headers.has('host');
+    this.lines.forEach(({ value }, name) => {
+      complete &&= keeps(name, value);
+    });
+    if (complete) {
+      return this.block;
+    }
+    const lines = headers.has('host') ? [] : [this.hostLine];
+    this.lines.forEach(({ value, line }, name) => {
+      if (keeps(name, value)) {
+        lines.push(line);
+      }
+    });
+    return Buffer.concat(lines);
+  }
+}
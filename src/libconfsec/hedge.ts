@@ -0,0 +1,213 @@
+/**
+ * Configuration for hedged requests
+ */
+export interface HedgingConfig {
+  /** Time in ms to wait for a response before hedging (default: 1000) */
+  delayMs?: number;
+  /**
+   * Hedge after this percentile of recently observed response latencies
+   * instead of delayMs, once enough latencies have been observed
+   */
+  percentile?: number;
+  /** Maximum number of hedges as a fraction of requests (default: 0.1) */
+  maxHedgeRatio?: number;
+}
+
+/**
+ * Hedging counters
+ */
+export interface HedgingStats {
+  /** Number of requests sent with hedging enabled */
+  requests: number;
+  /** Number of hedge requests sent */
+  hedges: number;
+  /** Number of hedge requests that responded before the original */
+  hedgeWins: number;
+  /** Number of hedges skipped because the budget was exhausted */
+  budgetExhausted: number;
+}
+
+// Latencies kept for percentile estimates, and the minimum needed to use them
+const LATENCY_WINDOW = 256;
+const MIN_LATENCY_SAMPLES = 20;
+// Unused budget carried over, so bursts of slow requests can all be hedged.
+// New clients start with this much, so their first requests are covered too.
+export const MAX_BUDGET_TOKENS = 10;
+
+/**
+ * Sliding window of recent latencies
+ */
+export class LatencyWindow {
+  private readonly capacity: number;
+  private samples: number[] = [];
+  private next = 0;
+
+  constructor(capacity: number = LATENCY_WINDOW) {
+    this.capacity = capacity;
+  }
+
+  get size(): number {
+    return this.samples.length;
+  }
+
+  record(latencyMs: number): void {
+    if (this.samples.length < this.capacity) {
+      this.samples.push(latencyMs);
+    } else {
+      this.samples[this.next] = latencyMs;
+      this.next = (this.next + 1) % this.capacity;
+    }
+  }
+
+  /**
+   * Get the given percentile (0-100) of the recorded latencies, or null if
+   * nothing has been recorded
+   */
+  percentile(p: number): number | null {
+    if (this.samples.length === 0) {
+      return null;
+    }
+    const sorted = [...this.samples].sort((a, b) => a - b);
+    const index = Math.ceil((p / 100) * sorted.length) - 1;
+    return sorted[Math.min(Math.max(index, 0), sorted.length - 1)];
+  }
+}
+
+/**
+ * Token bucket limiting extra requests to a fraction of all requests. Every
+ * request earns `ratio` tokens and every extra request spends one. The bucket
+ * starts with initialTokens, unless ratio is zero.
+ */
+export class RequestBudget {
+  private readonly ratio: number;
+  private readonly maxTokens: number;
+  private tokens: number;
+
+  constructor(
+    ratio: number,
+    initialTokens: number = 0,
+    maxTokens: number = MAX_BUDGET_TOKENS
+  ) {
+    this.ratio = ratio;
+    this.maxTokens = maxTokens;
+    this.tokens = ratio > 0 ? Math.min(initialTokens, maxTokens) : 0;
+  }
+
+  /** Record a request, earning budget for extra requests */
+  deposit(): void {
+    this.tokens = Math.min(this.tokens + this.ratio, this.maxTokens);
+  }
+
+  /** Try to spend budget on an extra request */
+  withdraw(): boolean {
+    if (this.tokens < 1) {
+      return false;
+    }
+    this.tokens -= 1;
+    return true;
+  }
+}
+
+/**
+ * Sends requests with hedging: if the first attempt hasn't responded after a
+ * delay, a second attempt is sent and whichever responds first wins. The
+ * losing response is closed as soon as it arrives.
+ */
+export class Hedger<T extends { close(): void }> {
+  private readonly delayMs: number;
+  private readonly percentile: number | null;
+  private readonly latencies = new LatencyWindow();
+  private readonly budget: RequestBudget;
+
+  private _stats: HedgingStats = {
+    requests: 0,
+    hedges: 0,
+    hedgeWins: 0,
+    budgetExhausted: 0,
+  };
+
+  constructor({
+    delayMs = 1000,
+    percentile,
+    maxHedgeRatio = 0.1,
+  }: HedgingConfig = {}) {
+    this.delayMs = delayMs;
+    this.percentile = percentile ?? null;
+    this.budget = new RequestBudget(maxHedgeRatio, MAX_BUDGET_TOKENS);
+  }
+
+  get stats(): HedgingStats {
+    return { ...this._stats };
+  }
+
+  /** Delay before the current request is hedged */
+  get currentDelayMs(): number {
+    if (
+      this.percentile === null ||
+      this.latencies.size < MIN_LATENCY_SAMPLES
+    ) {
+      return this.delayMs;
+    }
+    return this.latencies.percentile(this.percentile) ?? this.delayMs;
+  }
+
+  /**
+   * Run attempt, hedging it with a second attempt if it is slow
+   */
+  send(attempt: () => Promise<T>): Promise<T> {
+    this._stats.requests++;
+    this.budget.deposit();
+
+    return new Promise<T>((resolve, reject) => {
+      let settled = false;
+      let pending = 0;
+      let firstError: unknown = null;
+      let timer: ReturnType<typeof setTimeout> | null = null;
+
+      const launch = (isHedge: boolean) => {
+        const start = Date.now();
+        pending++;
+        attempt().then(
+          result => {
+            pending--;
+            if (settled) {
+              // Lost the race
+              result.close();
+              return;
+            }
+            settled = true;
+            if (timer !== null) clearTimeout(timer);
+            if (isHedge) this._stats.hedgeWins++;
+            this.latencies.record(Date.now() - start);
+            resolve(result);
+          },
+          (error: unknown) => {
+            pending--;
+            if (settled) return;
+            if (firstError === null) firstError = error;
+            // Fail once no attempt can still succeed. Failures are left to
+            // the retry policy rather than hedged.
+            if (pending === 0) {
+              settled = true;
+              if (timer !== null) clearTimeout(timer);
+              reject(firstError);
+            }
+          }
+        );
+      };
+
+      timer = setTimeout(() => {
+        timer = null;
+        if (settled) return;
+        if (this.budget.withdraw()) {
+          this._stats.hedges++;
+          launch(true);
+        } else {
+          this._stats.budgetExhausted++;
+        }
+      }, this.currentDelayMs);
+
+      launch(false);
+    });
+  }
+}
@@ -0,0 +1,311 @@
+import { ResponseTimings } from './response';
+
+/**
+ * Summary of a histogram. Every field is 0 if nothing has been recorded.
+ */
+export interface HistogramSnapshot {
+  count: number;
+  min: number;
+  max: number;
+  mean: number;
+  p50: number;
+  p90: number;
+  p99: number;
+  p999: number;
+}
+
+// Each power of two is split into linear sub-buckets. A bucket is at most 1/64
+// of its values wide, and percentiles are reported at its midpoint, which
+// bounds their error to 1/128 (under 0.8%) of their value.
+const SUB_BUCKET_BITS = 7;
+const SUB_BUCKET_COUNT = 2 ** SUB_BUCKET_BITS;
+const HALF_SUB_BUCKET_COUNT = SUB_BUCKET_COUNT / 2;
+// Largest power of two a value is scaled down by; larger values are clamped
+// into the last bucket
+const MAX_SHIFT = 30;
+const BUCKET_COUNT = SUB_BUCKET_COUNT + MAX_SHIFT * HALF_SUB_BUCKET_COUNT;
+
+function bucketIndex(units: number): number {
+  if (units < SUB_BUCKET_COUNT) {
+    return units;
+  }
+  const shift = Math.min(
+    Math.floor(Math.log2(units)) - SUB_BUCKET_BITS + 1,
+    MAX_SHIFT
+  );
+  const sub = Math.min(Math.floor(units / 2 ** shift), SUB_BUCKET_COUNT - 1);
+  const first = SUB_BUCKET_COUNT + (shift - 1) * HALF_SUB_BUCKET_COUNT;
+  return first + sub - HALF_SUB_BUCKET_COUNT;
+}
+
+// Midpoint, in units, of the values that fall into the bucket
+function bucketMidpoint(index: number): number {
+  if (index < SUB_BUCKET_COUNT) {
+    return index;
+  }
+  const offset = index - SUB_BUCKET_COUNT;
+  const shift = Math.floor(offset / HALF_SUB_BUCKET_COUNT) + 1;
+  const sub = (offset % HALF_SUB_BUCKET_COUNT) + HALF_SUB_BUCKET_COUNT;
+  return sub * 2 ** shift + (2 ** shift - 1) / 2;
+}
+
+/**
+ * Histogram with logarithmic buckets in the style of HdrHistogram. Values are
+ * quantized to multiples of 1 / scale, and memory use is fixed regardless of
+ * how many values are recorded.
+ */
+export class Histogram {
+  private readonly scale: number;
+  private readonly counts = new Uint32Array(BUCKET_COUNT);
+  private _count = 0;
+  private _sum = 0;
+  private min = Infinity;
+  private max = 0;
+
+  constructor(scale: number = 1000) {
+    this.scale = scale;
+  }
+
+  /** Number of values recorded */
+  get count(): number {
+    return this._count;
+  }
+
+  /** Sum of the values recorded */
+  get sum(): number {
+    return this._sum;
+  }
+
+  /** Record a value. Negative and non-finite values are ignored. */
+  record(value: number): void {
+    if (!(value >= 0) || value === Infinity) {
+      return;
+    }
+    this.counts[bucketIndex(Math.round(value * this.scale))]++;
+    this._count++;
+    this._sum += value;
+    this.min = Math.min(this.min, value);
+    this.max = Math.max(this.max, value);
+  }
+
+  /**
+   * Count the values at or below each of the given bounds, which must be in
+   * ascending order. Values are compared at the resolution of the buckets.
+   */
+  cumulativeCounts(bounds: number[]): number[] {
+    const result: number[] = [];
+    let seen = 0;
+    let i = 0;
+    for (const bound of bounds) {
+      const last = bucketIndex(Math.max(Math.round(bound * this.scale), 0));
+      for (; i <= last; i++) {
+        seen += this.counts[i];
+      }
+      result.push(seen);
+    }
+    return result;
+  }
+
+  /**
+   * Get the given percentile (0-100) of the recorded values, or 0 if nothing
+   * has been recorded
+   */
+  percentile(p: number): number {
+    if (this._count === 0) {
+      return 0;
+    }
+    const rank = Math.max(Math.ceil((p / 100) * this._count), 1);
+    let seen = 0;
+    for (let i = 0; i < BUCKET_COUNT; i++) {
+      seen += this.counts[i];
+      if (seen >= rank) {
+        const value = bucketMidpoint(i) / this.scale;
+        return Math.min(Math.max(value, this.min), this.max);
+      }
+    }
+    return this.max;
+  }
+
+  snapshot(): HistogramSnapshot {
+    return {
+      count: this._count,
+      min: this._count === 0 ? 0 : this.min,
+      max: this.max,
+      mean: this._count === 0 ? 0 : this._sum / this._count,
+      p50: this.percentile(50),
+      p90: this.percentile(90),
+      p99: this.percentile(99),
+      p999: this.percentile(99.9),
+    };
+  }
+
+  reset(): void {
+    this.counts.fill(0);
+    this._count = 0;
+    this._sum = 0;
+    this.min = Infinity;
+    this.max = 0;
+  }
+}
+
+/**
+ * Configuration for per-model latency histograms
+ */
+export interface LatencyHistogramsConfig {
+  /**
+   * Maximum number of models tracked separately; requests for any further
+   * models are recorded under OTHER_MODELS (default: 20)
+   */
+  maxModels?: number;
+}
+
+/**
+ * Latency distributions of the requests for one model
+ */
+export interface ModelLatencySnapshot {
+  /** Time in ms from the fetch call to the response headers */
+  ttfbMs: HistogramSnapshot;
+  /** Time in ms from the fetch call to the first event of a streamed body */
+  ttftMs: HistogramSnapshot;
+  /** Time in ms from the fetch call to the end of the body */
+  totalMs: HistogramSnapshot;
+  /** Completion tokens generated per second */
+  tokensPerSecond: HistogramSnapshot;
+}
+
+/** Key under which models beyond maxModels are recorded */
+export const OTHER_MODELS = '(other)';
+
+/**
+ * Histograms of the requests for one model
+ */
+export class ModelHistograms {
+  readonly ttfbMs = new Histogram();
+  readonly ttftMs = new Histogram();
+  readonly totalMs = new Histogram();
+  readonly tokensPerSecond = new Histogram(100);
+
+  snapshot(): ModelLatencySnapshot {
+    return {
+      ttfbMs: this.ttfbMs.snapshot(),
+      ttftMs: this.ttftMs.snapshot(),
+      totalMs: this.totalMs.snapshot(),
+      tokensPerSecond: this.tokensPerSecond.snapshot(),
+    };
+  }
+}
+
+/**
+ * Token usage observed in a response body
+ */
+export interface TokenCounts {
+  /** Number of SSE data events, excluding the final [DONE] */
+  events: number;
+  /** completion_tokens reported in the body's usage, if any */
+  completionTokens: number | null;
+}
+
+/**
+ * Latency histograms of completed requests, keyed by model
+ */
+export class LatencyHistograms {
+  private readonly maxModels: number;
+  private models = new Map<string, ModelHistograms>();
+
+  constructor({ maxModels = 20 }: LatencyHistogramsConfig = {}) {
+    this.maxModels = maxModels;
+  }
+
+  /**
+   * Record a closed response. Streamed bodies are recognized by their SSE
+   * events; their token rate excludes the wait for the first token.
+   */
+  record(model: string, timings: ResponseTimings, tokens: TokenCounts): void {
+    const { queued, submitted, headersReceived, firstChunk, lastChunk } =
+      timings;
+    if (queued === undefined || headersReceived === undefined) {
+      return;
+    }
+    const histograms = this.histogramsFor(model);
+    histograms.ttfbMs.record(headersReceived - queued);
+    histograms.totalMs.record((lastChunk ?? headersReceived) - queued);
+
+    const completionTokens = tokens.completionTokens ?? tokens.events;
+    if (tokens.events > 0) {
+      histograms.ttftMs.record(firstChunk! - queued);
+      if (completionTokens > 1 && lastChunk! > firstChunk!) {
+        histograms.tokensPerSecond.record(
+          ((completionTokens - 1) * 1000) / (lastChunk! - firstChunk!)
+        );
+      }
+    } else if (completionTokens > 0 && submitted !== undefined) {
+      histograms.tokensPerSecond.record(
+        (completionTokens * 1000) / (headersReceived - submitted)
+      );
+    }
+  }
+
+  snapshot(): Record<string, ModelLatencySnapshot> {
+    const result: Record<string, ModelLatencySnapshot> = {};
+    this.forEach((histograms, model) => {
+      result[model] = histograms.snapshot();
+    });
+    return result;
+  }
+
+  /** Run fn for the histograms of every tracked model */
+  forEach(fn: (histograms: ModelHistograms, model: string) => void): void {
+    this.models.forEach(fn);
+  }
+
+  /** Drop every recorded value and tracked model */
+  reset(): void {
+    this.models.clear();
+  }
+
+  private histogramsFor(model: string): ModelHistograms {
+    let histograms = this.models.get(model);
+    if (histograms === undefined) {
+      if (this.models.size >= this.maxModels) {
+        model = OTHER_MODELS;
+        histograms = this.models.get(model);
+      }
+      if (histograms === undefined) {
+        histograms = new ModelHistograms();
+        this.models.set(model, histograms);
+      }
+    }
+    return histograms;
+  }
+}
+
+const DATA_EVENT = Buffer.from('data:');
+const DONE_EVENT = Buffer.from('data: [DONE]');
+const COMPLETION_TOKENS = Buffer.from('"completion_tokens":');
+
+function countOccurrences(chunk: Buffer, needle: Buffer): number {
+  let count = 0;
+  let index = chunk.indexOf(needle);
+  while (index !== -1) {
+    count++;
+    index = chunk.indexOf(needle, index + needle.length);
+  }
+  return count;
+}
+
+/**
+ * Add the token usage found in a chunk of a response body to counts
+ */
+export function countTokens(chunk: Buffer, counts: TokenCounts): void {
+  counts.events +=
+    countOccurrences(chunk, DATA_EVENT) - countOccurrences(chunk, DONE_EVENT);
+  const index = chunk.indexOf(COMPLETION_TOKENS);
+  if (index !== -1) {
+    const match = /^\s*(\d+)/.exec(
+      chunk.toString('latin1', index + COMPLETION_TOKENS.length, index + 40)
+    );
+    if (match) {
+      counts.completionTokens = Number(match[1]);
+    }
+  }
+}
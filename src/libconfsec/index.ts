@@ -1,3 +1,38 @@
-export type { ILibconfsec, IdentityPolicySource } from './types';
+export type {
+  ILibconfsec,
+  IdentityPolicySource,
+  LiveHandle,
+  NativeCallStats,
+  NativeSpan,
+  NativeStats,
+  NativeTrace,
+  SlowCallHook,
+  StreamChunk,
+} from './types';
 export * from './client';
 export * from './response';
+export * from './errors';
+export type { RequestQueueConfig } from './queue';
+export type { ResponseCacheConfig, ResponseCacheStats } from './cache';
+export type { HedgingConfig, HedgingStats } from './hedge';
+export type { RetryConfig, RetryStats } from './retry';
+export type {
+  RequestBufferPoolConfig,
+  RequestBufferPoolStats,
+} from './bufferpool';
+export type {
+  HistogramSnapshot,
+  LatencyHistogramsConfig,
+  ModelLatencySnapshot,
+} from './histogram';
+export { DIAGNOSTICS_CHANNELS } from './diagnostics';
+export type {
+  RequestChunkMessage,
+  RequestEndMessage,
+  RequestErrorMessage,
+  RequestHeadersMessage,
+  RequestStartMessage,
+  ResponseSource,
+} from './diagnostics';
+export type { ChromeTrace, TraceEvent, TracingConfig } from './trace';
+export type { HandleTrackingConfig } from './leaks';
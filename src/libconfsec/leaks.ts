@@ -0,0 +1,89 @@
+import { ILibconfsec, LiveHandle } from './types';
+
+/**
+ * Configuration for tracking native handles, to find responses and streams
+ * that are never closed
+ */
+export interface HandleTrackingConfig {
+  /**
+   * Age in ms from which responses and streams are reported (default: 60000)
+   */
+  reportAfterMs?: number;
+  /** Interval in ms between checks for old handles (default: 10000) */
+  intervalMs?: number;
+  /**
+   * Called with the responses and streams that reached reportAfterMs since
+   * the previous check (default: log them with console.warn)
+   */
+  onReport?: (handles: LiveHandle[]) => void;
+}
+
+function warnLiveHandles(handles: LiveHandle[]): void {
+  const details = handles.map(({ kind, handle, ageMs, stack }) => {
+    const age = Math.round(ageMs / 1000);
+    return `${kind} ${handle} open for ${age}s, created\n${stack}`;
+  });
+  console.warn(
+    `confsec: ${handles.length} handle(s) not closed:\n${details.join('\n')}`
+  );
+}
+
+/**
+ * Enables handle tracking in the binding while open, and periodically reports
+ * the responses and streams older than reportAfterMs. Each handle is reported
+ * once.
+ */
+export class HandleTracker {
+  private readonly libconfsec: ILibconfsec;
+  private readonly reportAfterMs: number;
+  private readonly onReport: (handles: LiveHandle[]) => void;
+  private readonly timer: NodeJS.Timeout;
+  private reported = new Set<string>();
+
+  constructor(
+    libconfsec: ILibconfsec,
+    {
+      reportAfterMs = 60000,
+      intervalMs = 10000,
+      onReport = warnLiveHandles,
+    }: HandleTrackingConfig
+  ) {
+    this.libconfsec = libconfsec;
+    this.reportAfterMs = reportAfterMs;
+    this.onReport = onReport;
+    this.libconfsec.confsecTrackHandles(true);
+    this.timer = setInterval(() => this.check(), intervalMs);
+    this.timer.unref();
+  }
+
+  /** Report the responses and streams that became older than reportAfterMs */
+  check(): void {
+    const live = new Set<string>();
+    const old: LiveHandle[] = [];
+    this.libconfsec.confsecGetLiveHandles().forEach(handle => {
+      if (handle.kind === 'client') {
+        return;
+      }
+      const key = `${handle.kind}:${handle.handle}`;
+      live.add(key);
+      if (handle.ageMs >= this.reportAfterMs && !this.reported.has(key)) {
+        this.reported.add(key);
+        old.push(handle);
+      }
+    });
+    // Handle values may be reused once destroyed
+    this.reported.forEach(key => {
+      if (!live.has(key)) {
+        this.reported.delete(key);
+      }
+    });
+    if (old.length > 0) {
+      this.onReport(old);
+    }
+  }
+
+  close(): void {
+    clearInterval(this.timer);
+    this.libconfsec.confsecTrackHandles(false);
+  }
+}
@@ -0,0 +1,408 @@
+import type { WalletStatus } from './client';
+import type { ResponseCacheStats } from './cache';
+import type { HedgingStats } from './hedge';
+import type { RetryStats } from './retry';
+import type { NativeCallStats, NativeStats } from './types';
+import { Histogram, LatencyHistograms, ModelHistograms } from './histogram';
+
+/**
+ * Labels identifying one series of a metric
+ */
+export type Labels = Record<string, string>;
+
+/**
+ * One series of a histogram metric
+ */
+export interface HistogramSeries {
+  labels: Labels;
+  histogram: Histogram;
+}
+
+// Upper bounds of the buckets of latency histograms, in ms
+const LATENCY_BUCKETS_MS = [
+  5, 10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000, 30000, 60000,
+];
+// Upper bounds of the buckets of token rate histograms, in tokens per second
+const TOKEN_RATE_BUCKETS = [1, 5, 10, 20, 50, 100, 200, 500, 1000];
+// Last bucket of native call stats written, whose bound is 2^24us (16.8s)
+const NATIVE_CALL_MAX_BUCKET = 24;
+
+function formatValue(value: number): string {
+  if (Number.isFinite(value)) {
+    return String(value);
+  }
+  if (Number.isNaN(value)) {
+    return 'NaN';
+  }
+  return value > 0 ? '+Inf' : '-Inf';
+}
+
+function escapeLabelValue(value: string): string {
+  return value
+    .replace(/\\/g, '\\\\')
+    .replace(/"/g, '\\"')
+    .replace(/\n/g, '\\n');
+}
+
+function formatLabels(labels: Labels): string {
+  const pairs = Object.entries(labels).map(
+    ([name, value]) => `${name}="${escapeLabelValue(value)}"`
+  );
+  return pairs.length === 0 ? '' : `{${pairs.join(',')}}`;
+}
+
+/**
+ * Builds a scrape in the Prometheus text exposition format
+ */
+export class PrometheusWriter {
+  private lines: string[] = [];
+
+  /**
+   * Write a counter or gauge, given either its value or a value for each of
+   * its series
+   */
+  metric(
+    name: string,
+    type: 'counter' | 'gauge',
+    help: string,
+    samples: number | [Labels, number][]
+  ): this {
+    this.header(name, type, help);
+    if (typeof samples === 'number') {
+      this.sample(name, {}, samples);
+    } else {
+      samples.forEach(([labels, value]) => this.sample(name, labels, value));
+    }
+    return this;
+  }
+
+  /**
+   * Write a histogram. Bucket bounds are in the unit values were recorded
+   * in, and are multiplied by scale when written, as is the sum.
+   */
+  histogram(
+    name: string,
+    help: string,
+    series: HistogramSeries[],
+    bounds: number[],
+    scale: number = 1
+  ): this {
+    this.header(name, 'histogram', help);
+    series.forEach(({ labels, histogram }) => {
+      const counts = histogram.cumulativeCounts(bounds);
+      this.buckets(
+        name,
+        labels,
+        bounds.map((bound, i) => [bound * scale, counts[i]]),
+        histogram.sum * scale,
+        histogram.count
+      );
+    });
+    return this;
+  }
+
+  /**
+   * Write a histogram whose series are already bucketed, given the upper
+   * bound and cumulative count of each of their buckets
+   */
+  bucketedHistogram(
+    name: string,
+    help: string,
+    series: [Labels, [number, number][], number, number][]
+  ): this {
+    this.header(name, 'histogram', help);
+    series.forEach(([labels, buckets, sum, count]) =>
+      this.buckets(name, labels, buckets, sum, count)
+    );
+    return this;
+  }
+
+  toString(): string {
+    return this.lines.join('\n') + '\n';
+  }
+
+  private header(name: string, type: string, help: string): void {
+    this.lines.push(`# HELP ${name} ${help}`);
+    this.lines.push(`# TYPE ${name} ${type}`);
+  }
+
+  private buckets(
+    name: string,
+    labels: Labels,
+    buckets: [number, number][],
+    sum: number,
+    count: number
+  ): void {
+    buckets.forEach(([bound, cumulative]) => {
+      const le = formatValue(bound);
+      this.sample(`${name}_bucket`, { ...labels, le }, cumulative);
+    });
+    this.sample(`${name}_bucket`, { ...labels, le: '+Inf' }, count);
+    this.sample(`${name}_sum`, labels, sum);
+    this.sample(`${name}_count`, labels, count);
+  }
+
+  private sample(name: string, labels: Labels, value: number): void {
+    this.lines.push(`${name}${formatLabels(labels)} ${formatValue(value)}`);
+  }
+}
+
+/**
+ * Write the wallet gauges, which are left out if the wallet status couldn't be
+ * fetched, and the count of such failures
+ */
+export function writeWalletMetrics(
+  writer: PrometheusWriter,
+  wallet: WalletStatus | null,
+  errors: number
+): void {
+  writer.metric(
+    'confsec_wallet_status_errors_total',
+    'counter',
+    'Failures to fetch the wallet status for metrics',
+    errors
+  );
+  if (wallet === null) {
+    return;
+  }
+  writer
+    .metric(
+      'confsec_wallet_credits_available',
+      'gauge',
+      'Credits available in the wallet',
+      wallet.credits_available
+    )
+    .metric(
+      'confsec_wallet_credits_held',
+      'gauge',
+      'Credits held for requests in progress',
+      wallet.credits_held
+    )
+    .metric(
+      'confsec_wallet_credits_spent',
+      'gauge',
+      'Credits spent by the wallet',
+      wallet.credits_spent
+    );
+}
+
+export function writeNativeMetrics(
+  writer: PrometheusWriter,
+  stats: NativeStats
+): void {
+  writer
+    .metric(
+      'confsec_native_clients',
+      'gauge',
+      'Native clients in the process',
+      stats.liveClients
+    )
+    .metric(
+      'confsec_native_requests_in_flight',
+      'gauge',
+      'Requests waiting for libconfsec in the process',
+      stats.inFlightRequests
+    )
+    .metric(
+      'confsec_native_responses',
+      'gauge',
+      'Native responses not yet destroyed in the process',
+      stats.liveResponses
+    )
+    .metric(
+      'confsec_native_streams',
+      'gauge',
+      'Native response streams not yet destroyed in the process',
+      stats.openStreams
+    )
+    .metric(
+      'confsec_native_request_bytes',
+      'gauge',
+      'Request bytes held by the binding in the process',
+      stats.nativeBytesOutstanding
+    )
+    .metric(
+      'confsec_native_requests_total',
+      'counter',
+      'Requests sent through libconfsec by the process',
+      stats.requests
+    )
+    .metric(
+      'confsec_native_chunks_total',
+      'counter',
+      'Stream chunks delivered by libconfsec to the process',
+      stats.chunks
+    )
+    .metric(
+      'confsec_native_bytes_total',
+      'counter',
+      'Body and chunk bytes delivered by libconfsec to the process',
+      stats.bytesDelivered
+    )
+    .metric(
+      'confsec_native_errors_total',
+      'counter',
+      'Errors raised by libconfsec in the process, by class',
+      Object.entries(stats.errors).map(([code, count]) => [{ code }, count])
+    );
+}
+
+/**
+ * Write the time spent in synchronous native calls, for the functions that
+ * have been called. Only every other power-of-two bucket of the binding is
+ * written, from 1us to 16s.
+ */
+export function writeNativeCallMetrics(
+  writer: PrometheusWriter,
+  stats: Record<string, NativeCallStats>
+): void {
+  const series: [Labels, [number, number][], number, number][] = [];
+  Object.entries(stats).forEach(([fn, call]) => {
+    if (call.calls === 0) {
+      return;
+    }
+    const buckets: [number, number][] = [];
+    let cumulative = 0;
+    call.buckets.forEach((count, i) => {
+      cumulative += count;
+      if (i % 2 === 0 && i <= NATIVE_CALL_MAX_BUCKET) {
+        buckets.push([2 ** i / 1e6, cumulative]);
+      }
+    });
+    series.push([{ function: fn }, buckets, call.totalMs / 1000, call.calls]);
+  });
+  writer.bucketedHistogram(
+    'confsec_native_call_seconds',
+    'Time synchronous native calls blocked the event loop, by function',
+    series
+  );
+}
+
+export function writeCacheMetrics(
+  writer: PrometheusWriter,
+  stats: ResponseCacheStats
+): void {
+  writer
+    .metric(
+      'confsec_cache_requests_total',
+      'counter',
+      'Cacheable fetch requests, by whether they were served from the cache',
+      [
+        [{ result: 'hit' }, stats.hits],
+        [{ result: 'miss' }, stats.misses],
+      ]
+    )
+    .metric(
+      'confsec_cache_removals_total',
+      'counter',
+      'Responses removed from the cache, by reason',
+      [
+        [{ reason: 'evicted' }, stats.evictions],
+        [{ reason: 'expired' }, stats.expirations],
+      ]
+    )
+    .metric(
+      'confsec_cache_entries',
+      'gauge',
+      'Responses in the cache',
+      stats.entries
+    )
+    .metric(
+      'confsec_cache_bytes',
+      'gauge',
+      'Approximate size of the cache',
+      stats.bytes
+    );
+}
+
+export function writeHedgingMetrics(
+  writer: PrometheusWriter,
+  stats: HedgingStats
+): void {
+  writer
+    .metric(
+      'confsec_hedged_requests_total',
+      'counter',
+      'Fetch requests sent with hedging enabled',
+      stats.requests
+    )
+    .metric(
+      'confsec_hedges_total',
+      'counter',
+      'Hedge requests sent',
+      stats.hedges
+    )
+    .metric(
+      'confsec_hedge_wins_total',
+      'counter',
+      'Hedge requests that responded before the original',
+      stats.hedgeWins
+    )
+    .metric(
+      'confsec_hedges_skipped_total',
+      'counter',
+      'Hedges skipped because the budget was exhausted',
+      stats.budgetExhausted
+    );
+}
+
+export function writeRetryMetrics(
+  writer: PrometheusWriter,
+  stats: RetryStats
+): void {
+  writer
+    .metric('confsec_retries_total', 'counter', 'Retries sent', stats.retries)
+    .metric(
+      'confsec_retries_recovered_total',
+      'counter',
+      'Fetch requests that succeeded after a retry',
+      stats.recovered
+    )
+    .metric(
+      'confsec_retries_skipped_total',
+      'counter',
+      'Retries skipped because the budget was exhausted',
+      stats.budgetExhausted
+    );
+}
+
+export function writeLatencyMetrics(
+  writer: PrometheusWriter,
+  histograms: LatencyHistograms
+): void {
+  const series = (select: (model: ModelHistograms) => Histogram) => {
+    const result: HistogramSeries[] = [];
+    histograms.forEach((model, name) => {
+      result.push({ labels: { model: name }, histogram: select(model) });
+    });
+    return result;
+  };
+  writer
+    .histogram(
+      'confsec_ttfb_seconds',
+      'Time from the fetch call to the response headers, by model',
+      series(model => model.ttfbMs),
+      LATENCY_BUCKETS_MS,
+      0.001
+    )
+    .histogram(
+      'confsec_ttft_seconds',
+      'Time from the fetch call to the first streamed event, by model',
+      series(model => model.ttftMs),
+      LATENCY_BUCKETS_MS,
+      0.001
+    )
+    .histogram(
+      'confsec_request_duration_seconds',
+      'Time from the fetch call to the end of the body, by model',
+      series(model => model.totalMs),
+      LATENCY_BUCKETS_MS,
+      0.001
+    )
+    .histogram(
+      'confsec_tokens_per_second',
+      'Completion tokens generated per second, by model',
+      series(model => model.tokensPerSecond),
+      TOKEN_RATE_BUCKETS
+    );
+}
@@ -0,0 +1,155 @@
+import { ConfsecOverloadError } from './errors';
+
+/**
+ * Limits applied to requests admitted by a client
+ */
+export interface RequestQueueConfig {
+  /** Maximum number of requests in flight at once (default: unlimited) */
+  maxConcurrentRequests?: number;
+  /** Maximum number of requests waiting for a slot (default: unlimited) */
+  maxQueueDepth?: number;
+  /** Maximum time in ms a request may wait (default: unlimited) */
+  maxQueueWaitMs?: number;
+}
+
+/** Releases a slot acquired from a RequestQueue. Safe to call more than once. */
+export type ReleaseSlot = () => void;
+
+interface Waiter {
+  resolve: (release: ReleaseSlot) => void;
+  reject: (error: Error) => void;
+  timer: ReturnType<typeof setTimeout> | null;
+}
+
+/**
+ * Admission queue for requests. Requests beyond the concurrency limit wait in
+ * FIFO order; once the queue is full, or a request has waited too long, it is
+ * rejected with a ConfsecOverloadError rather than left to pile up.
+ */
+export class RequestQueue {
+  private readonly maxConcurrentRequests: number;
+  private readonly maxQueueDepth: number;
+  private readonly maxQueueWaitMs: number;
+
+  private active = 0;
+  private waiters: Waiter[] = [];
+  private closed = false;
+
+  private _rejectedQueueFull = 0;
+  private _rejectedQueueTimeout = 0;
+
+  constructor({
+    maxConcurrentRequests = Infinity,
+    maxQueueDepth = Infinity,
+    maxQueueWaitMs = Infinity,
+  }: RequestQueueConfig = {}) {
+    if (!(maxConcurrentRequests >= 1)) {
+      throw new RangeError('maxConcurrentRequests must be at least 1');
+    }
+    if (!(maxQueueDepth >= 0) || !(maxQueueWaitMs >= 0)) {
+      throw new RangeError('Queue limits must be non-negative');
+    }
+    this.maxConcurrentRequests = maxConcurrentRequests;
+    this.maxQueueDepth = maxQueueDepth;
+    this.maxQueueWaitMs = maxQueueWaitMs;
+  }
+
+  /** Number of requests currently holding a slot */
+  get inFlight(): number {
+    return this.active;
+  }
+
+  /** Number of requests waiting for a slot */
+  get depth(): number {
+    return this.waiters.length;
+  }
+
+  /** Number of requests rejected because the queue was full */
+  get rejectedQueueFull(): number {
+    return this._rejectedQueueFull;
+  }
+
+  /** Number of requests rejected because they waited too long */
+  get rejectedQueueTimeout(): number {
+    return this._rejectedQueueTimeout;
+  }
+
+  /**
+   * Wait for a free slot
+   * @returns Function that must be called to release the slot
+   */
+  acquire(): Promise<ReleaseSlot> {
+    if (this.closed) {
+      return Promise.reject(new Error('Client is closed'));
+    }
+    if (this.active < this.maxConcurrentRequests) {
+      this.active++;
+      return Promise.resolve(this.releaser());
+    }
+    if (this.waiters.length >= this.maxQueueDepth) {
+      this._rejectedQueueFull++;
+      return Promise.reject(
+        new ConfsecOverloadError(
+          'queue_full',
+          `Request queue is full (${this.waiters.length} waiting)`
+        )
+      );
+    }
+
+    return new Promise<ReleaseSlot>((resolve, reject) => {
+      const waiter: Waiter = { resolve, reject, timer: null };
+      if (this.maxQueueWaitMs !== Infinity) {
+        waiter.timer = setTimeout(() => {
+          this.removeWaiter(waiter);
+          this._rejectedQueueTimeout++;
+          reject(
+            new ConfsecOverloadError(
+              'queue_timeout',
+              `Request waited more than ${this.maxQueueWaitMs}ms for a slot`
+            )
+          );
+        }, this.maxQueueWaitMs);
+      }
+      this.waiters.push(waiter);
+    });
+  }
+
+  /**
+   * Reject all waiting requests. Slots already handed out stay valid until
+   * they are released.
+   */
+  close(): void {
+    this.closed = true;
+    const waiters = this.waiters;
+    this.waiters = [];
+    waiters.forEach(waiter => {
+      if (waiter.timer !== null) clearTimeout(waiter.timer);
+      waiter.reject(new Error('Client is closed'));
+    });
+  }
+
+  private releaser(): ReleaseSlot {
+    let released = false;
+    return () => {
+      if (released) return;
+      released = true;
+      this.release();
+    };
+  }
+
+  private release(): void {
+    const next = this.waiters.shift();
+    if (next === undefined) {
+      this.active--;
+      return;
+    }
+    // Hand the slot straight to the next waiter
+    if (next.timer !== null) clearTimeout(next.timer);
+    next.resolve(this.releaser());
+  }
+
+  private removeWaiter(waiter: Waiter): void {
+    const index = this.waiters.indexOf(waiter);
+    if (index !== -1) this.waiters.splice(index, 1);
+  }
+}
@@ -1,4 +1,4 @@
-import { ILibconfsec } from './types';
+import { ILibconfsec, StreamChunk } from './types';
 import { Closeable } from '../closeable';
 
 export interface KV {
@@ -17,6 +17,67 @@ export interface ResponseMetadata {
   headers: KV[];
 }
 
+/**
+ * Monotonic timestamps, in milliseconds as returned by performance.now(), of
+ * each phase of a request. Phases that have not happened yet are undefined.
+ */
+export interface ResponseTimings {
+  /** The fetch call was made */
+  queued?: number;
+  /** The request was serialized to HTTP */
+  serialized?: number;
+  /** The request was handed to libconfsec */
+  submitted?: number;
+  /** libconfsec returned the response and its headers */
+  headersReceived?: number;
+  /** The first chunk was read, or the body of a non-streaming response */
+  firstChunk?: number;
+  /** The most recent chunk was read, or the body of a non-streaming response */
+  lastChunk?: number;
+  /** The response was closed */
+  closed?: number;
+}
+
+/**
+ * When a chunk read on the thread pool was returned by libconfsec and when it
+ * reached JS, in milliseconds as returned by performance.now(). The
+ * difference is time spent waiting for the event loop, not for the backend.
+ */
+export interface ChunkTiming {
+  receivedAt: number;
+  deliveredAt: number;
+  /** Size of the chunk in bytes */
+  bytes: number;
+}
+
+/** Name of the header reporting timings on fetch responses */
+export const TIMINGS_HEADER = 'x-confsec-timings';
+
+const TIMING_PHASES = [
+  'serialized',
+  'submitted',
+  'headersReceived',
+  'firstChunk',
+  'lastChunk',
+  'closed',
+] as const;
+
+/**
+ * Format timings as a header value, e.g. "serialized=0.21, submitted=0.3,
+ * headersReceived=48.95", giving the milliseconds from the fetch call to each
+ * phase that has happened
+ */
+export function formatTimings(timings: ResponseTimings): string {
+  const origin = timings.queued ?? timings.submitted ?? 0;
+  return TIMING_PHASES.filter(phase => timings[phase] !== undefined)
+    .map(phase => `${phase}=${round(timings[phase]! - origin)}`)
+    .join(', ');
+}
+
+function round(ms: number): number {
+  return Math.round(ms * 1000) / 1000;
+}
+
 /**
  * CONFSEC response object
  */
@@ -27,11 +88,30 @@ export class ConfsecResponse extends Closeable {
   private _metadata: ResponseMetadata | null = null;
   private _isStreaming: boolean | null = null;
   private _body: Buffer | null = null;
+  private chunkListeners: ((chunk: Buffer) => void)[] = [];
+  private errorListeners: ((error: unknown) => void)[] = [];
+
+  /** When each phase of the request happened */
+  readonly timings: ResponseTimings;
+
+  /** When each chunk read asynchronously from the stream was received */
+  readonly chunkTimings: ChunkTiming[] = [];
+
+  /**
+   * Whether readable streams of the response read chunks on the thread pool
+   * rather than blocking the event loop until each chunk arrives
+   */
+  asyncStreamReads = false;
 
-  constructor(libconfsec: ILibconfsec, handle: number) {
+  constructor(
+    libconfsec: ILibconfsec,
+    handle: number,
+    timings: ResponseTimings = {}
+  ) {
     super();
     this._handle = handle;
     this.libconfsec = libconfsec;
+    this.timings = timings;
   }
 
   /** Internal handle */
@@ -73,7 +153,46 @@ export class ConfsecResponse extends Closeable {
   }
 
   private getBody(): Buffer {
-    return this.libconfsec.confsecResponseGetBody(this._handle);
+    const body = this.libconfsec.confsecResponseGetBody(this._handle);
+    this.recordChunk(body);
+    return body;
+  }
+
+  /**
+   * Register a listener to run for every chunk read from the response's
+   * stream, or with the body of a non-streaming response
+   */
+  onChunk(listener: (chunk: Buffer) => void): void {
+    this.chunkListeners.push(listener);
+  }
+
+  /**
+   * Register a listener to run if reading the response's stream fails
+   */
+  onError(listener: (error: unknown) => void): void {
+    this.errorListeners.push(listener);
+  }
+
+  /**
+   * Note that reading the response's stream failed. Called by the stream.
+   */
+  recordError(error: unknown): void {
+    this.errorListeners.forEach(listener => listener(error));
+  }
+
+  /**
+   * Note that a chunk of the body has been read. Called by the response's
+   * stream for every chunk.
+   */
+  recordChunk(chunk: Buffer, timing?: ChunkTiming): void {
+    this.timings.lastChunk = timing?.deliveredAt ?? performance.now();
+    if (this.timings.firstChunk === undefined) {
+      this.timings.firstChunk = this.timings.lastChunk;
+    }
+    if (timing !== undefined) {
+      this.chunkTimings.push(timing);
+    }
+    this.chunkListeners.forEach(listener => listener(chunk));
   }
 
   /**
@@ -85,6 +204,7 @@ export class ConfsecResponse extends Closeable {
   }
 
   protected doClose(): void {
+    this.timings.closed = performance.now();
     this.libconfsec.confsecResponseDestroy(this._handle);
   }
 }
@@ -94,9 +214,10 @@ export class ConfsecResponse extends Closeable {
  */
 export class ConfsecResponseStream extends Closeable {
   private _handle: number;
-  // eslint-disable-next-line @typescript-eslint/no-unused-vars
   private resp: ConfsecResponse;
   private libconfsec: ILibconfsec;
+  // Read running on the thread pool, which the stream must outlive
+  private pendingRead: Promise<unknown> | null = null;
 
   constructor(libconfsec: ILibconfsec, resp: ConfsecResponse, handle: number) {
     super();
@@ -114,7 +235,67 @@ export class ConfsecResponseStream extends Closeable {
    * @returns Buffer containing the chunk, or null if no more chunks
    */
   getNext(): Buffer | null {
-    return this.libconfsec.confsecResponseStreamGetNext(this._handle);
+    let chunk: Buffer | null;
+    try {
+      chunk = this.libconfsec.confsecResponseStreamGetNext(this._handle);
+    } catch (e) {
+      this.resp.recordError(e);
+      throw e;
+    }
+    if (chunk !== null) {
+      this.resp.recordChunk(chunk);
+    }
+    return chunk;
+  }
+
+  /**
+   * Get the next chunk from the stream without blocking the event loop. The
+   * time the chunk was received is recorded in the response's chunkTimings.
+   * @returns Buffer containing the chunk, or null if no more chunks
+   */
+  async getNextAsync(): Promise<Buffer | null> {
+    if (this.pendingRead !== null) {
+      throw new Error('A read is already in progress');
+    }
+    const read = this.libconfsec.confsecResponseStreamGetNextAsync(
+      this._handle
+    );
+    this.pendingRead = read;
+    let result: StreamChunk;
+    try {
+      result = await read;
+    } catch (e) {
+      this.resp.recordError(e);
+      throw e;
+    } finally {
+      this.pendingRead = null;
+    }
+    const { chunk, delayMs } = result;
+    if (chunk !== null) {
+      const deliveredAt = performance.now();
+      this.resp.recordChunk(chunk, {
+        receivedAt: deliveredAt - delayMs,
+        deliveredAt,
+        bytes: chunk.length,
+      });
+    }
+    return chunk;
+  }
+
+  [Symbol.asyncIterator](): AsyncIterableIterator<Buffer> {
+    return {
+      next: async () => {
+        const chunk = await this.getNextAsync();
+        if (chunk === null) {
+          this.close();
+          return { done: true, value: undefined };
+        }
+        return { done: false, value: chunk };
+      },
+      [Symbol.asyncIterator]() {
+        return this;
+      },
+    };
   }
 
   [Symbol.iterator](): IterableIterator<Buffer> {
@@ -131,9 +312,13 @@ export class ConfsecResponseStream extends Closeable {
   }
 
   /**
-   * Create a ReadableStream from this ConfsecResponseStream
+   * Create a ReadableStream from this ConfsecResponseStream. Chunks are read
+   * asynchronously if the response's asyncStreamReads is set.
    */
   toReadableStream(): ReadableStream<Uint8Array> {
+    if (this.resp.asyncStreamReads) {
+      return this.toAsyncReadableStream();
+    }
     const iterator = this[Symbol.iterator]();
 
     return new ReadableStream<Uint8Array>({
@@ -164,10 +349,42 @@ export class ConfsecResponseStream extends Closeable {
     });
   }
 
+  private toAsyncReadableStream(): ReadableStream<Uint8Array> {
+    const iterator = this[Symbol.asyncIterator]();
+
+    return new ReadableStream<Uint8Array>({
+      async pull(controller) {
+        try {
+          const result = await iterator.next();
+          if (result.done) {
+            controller.close();
+            return;
+          }
+          controller.enqueue(new Uint8Array(result.value));
+        } catch (error) {
+          controller.error(error);
+        }
+      },
+
+      cancel: () => {
+        this.close();
+      },
+    });
+  }
+
   /**
-   * Destroy the stream and free resources
+   * Destroy the stream and free resources. If a read is running on the
+   * thread pool, the stream is destroyed once it finishes.
    */
   protected doClose(): void {
+    if (this.pendingRead !== null) {
+      const destroy = () => {
+        this.libconfsec.confsecResponseStreamDestroy(this._handle);
+        this.resp.close();
+      };
+      this.pendingRead.then(destroy, destroy);
+      return;
+    }
     this.libconfsec.confsecResponseStreamDestroy(this._handle);
     this.resp.close();
   }
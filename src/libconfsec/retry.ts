@@ -0,0 +1,149 @@
+import { ConfsecErrorCode, getErrorCode, isTransientError } from './errors';
+import { MAX_BUDGET_TOKENS, RequestBudget } from './hedge';
+
+/**
+ * Configuration for retrying failed requests
+ */
+export interface RetryConfig {
+  /** Maximum number of attempts per request (default: 3) */
+  maxAttempts?: number;
+  /** Backoff before the first retry in ms, doubling per retry (default: 100) */
+  baseDelayMs?: number;
+  /** Maximum backoff between attempts in ms (default: 2000) */
+  maxDelayMs?: number;
+  /** Maximum number of retries as a fraction of requests (default: 0.2) */
+  maxRetryRatio?: number;
+  /**
+   * Retry non-idempotent requests after failures that may have reached a
+   * node, such as timeouts and network errors (default: false)
+   */
+  retryNonIdempotent?: boolean;
+}
+
+/**
+ * Retry counters
+ */
+export interface RetryStats {
+  /** Number of retries sent */
+  retries: number;
+  /** Number of requests that succeeded after at least one retry */
+  recovered: number;
+  /** Number of retries skipped because the budget was exhausted */
+  budgetExhausted: number;
+}
+
+// Failures raised before the request was sent to any node, which are safe to
+// retry whatever the request
+const UNSENT_ERROR_CODES: ReadonlySet<ConfsecErrorCode> = new Set([
+  'CONFSEC_NO_NODES',
+  'CONFSEC_RATE_LIMITED',
+]);
+
+/**
+ * Retries requests that failed with transient errors, with exponential backoff
+ * and full jitter. Retries are limited by a budget so that an outage doesn't
+ * multiply the load on the network.
+ */
+export class RetryPolicy {
+  private readonly maxAttempts: number;
+  private readonly baseDelayMs: number;
+  private readonly maxDelayMs: number;
+  private readonly retryNonIdempotent: boolean;
+  private readonly budget: RequestBudget;
+
+  private _stats: RetryStats = {
+    retries: 0,
+    recovered: 0,
+    budgetExhausted: 0,
+  };
+
+  constructor({
+    maxAttempts = 3,
+    baseDelayMs = 100,
+    maxDelayMs = 2000,
+    maxRetryRatio = 0.2,
+    retryNonIdempotent = false,
+  }: RetryConfig = {}) {
+    this.maxAttempts = maxAttempts;
+    this.baseDelayMs = baseDelayMs;
+    this.maxDelayMs = maxDelayMs;
+    this.retryNonIdempotent = retryNonIdempotent;
+    // Start with credit, so failures right after startup are retried
+    this.budget = new RequestBudget(maxRetryRatio, MAX_BUDGET_TOKENS);
+  }
+
+  get stats(): RetryStats {
+    return { ...this._stats };
+  }
+
+  /**
+   * Run attempt, retrying it while it fails with retryable errors
+   * @param attempt - Sends the request
+   * @param idempotent - Whether the request may safely be sent more than once
+   */
+  async send<T>(attempt: () => Promise<T>, idempotent: boolean): Promise<T> {
+    this.budget.deposit();
+    for (let attempts = 1; ; attempts++) {
+      try {
+        const result = await attempt();
+        if (attempts > 1) this._stats.recovered++;
+        return result;
+      } catch (e) {
+        if (attempts >= this.maxAttempts || !this.isRetryable(e, idempotent)) {
+          throw e;
+        }
+        if (!this.budget.withdraw()) {
+          this._stats.budgetExhausted++;
+          throw e;
+        }
+        this._stats.retries++;
+        await sleep(this.backoffMs(attempts));
+      }
+    }
+  }
+
+  /** Randomized delay before the given retry (1-based) */
+  backoffMs(retry: number): number {
+    const ceiling = Math.min(
+      this.maxDelayMs,
+      this.baseDelayMs * 2 ** (retry - 1)
+    );
+    return Math.random() * ceiling;
+  }
+
+  private isRetryable(error: unknown, idempotent: boolean): boolean {
+    if (!isTransientError(error)) {
+      return false;
+    }
+    const code = getErrorCode(error);
+    return (
+      (code !== null && UNSENT_ERROR_CODES.has(code)) ||
+      idempotent ||
+      this.retryNonIdempotent
+    );
+  }
+}
+
+const IDEMPOTENT_METHODS = new Set([
+  'GET',
+  'HEAD',
+  'OPTIONS',
+  'TRACE',
+  'PUT',
+  'DELETE',
+]);
+
+/**
+ * Whether a request may safely be sent more than once: either its method is
+ * idempotent or it carries an idempotency key
+ */
+export function isIdempotent(request: Request): boolean {
+  return (
+    IDEMPOTENT_METHODS.has(request.method.toUpperCase()) ||
+    request.headers.has('idempotency-key')
+  );
+}
+
+function sleep(ms: number): Promise<void> {
+  return new Promise(resolve => setTimeout(resolve, ms));
+}
@@ -0,0 +1,261 @@
+import { createHash } from 'crypto';
+import {
+  ConfsecResponse,
+  KV,
+  TIMINGS_HEADER,
+  formatTimings,
+} from './response';
+
+/**
+ * Compute the key identifying a serialized request and its per-request node
+ * tags
+ */
+export function requestKey(
+  rawRequest: Buffer,
+  nodeTags?: readonly string[]
+): string {
+  const hash = createHash('sha256');
+  // Serialized requests start with their method, so can't be mistaken for tags
+  if (nodeTags !== undefined && nodeTags.length > 0) {
+    hash.update(JSON.stringify(nodeTags));
+  }
+  return hash.update(rawRequest).digest('hex');
+}
+
+/**
+ * Response body that can be read by any number of consumers. Chunks read from
+ * the source are retained so consumers that subscribe late still see the
+ * whole body.
+ */
+export class SharedBody {
+  private chunks: Uint8Array[] = [];
+  private reader: ReadableStreamDefaultReader<Uint8Array> | null;
+  private reading: Promise<void> | null = null;
+  private subscribers = 0;
+  private completeListeners: (() => void)[] = [];
+
+  private done = false;
+  private failed = false;
+  private error: unknown = null;
+
+  constructor(source: ReadableStream<Uint8Array> | Uint8Array) {
+    if (source instanceof Uint8Array) {
+      this.chunks.push(source);
+      this.reader = null;
+      this.done = true;
+    } else {
+      this.reader = source.getReader();
+    }
+  }
+
+  /** Whether the source has been fully read, has failed or was cancelled */
+  get isComplete(): boolean {
+    return this.done || this.failed;
+  }
+
+  /**
+   * Chunks of the body, or null if the source has not been fully read
+   */
+  get chunksIfDone(): Uint8Array[] | null {
+    return this.done ? this.chunks : null;
+  }
+
+  /**
+   * Register a listener to run once the source has been fully read, has
+   * failed or was cancelled
+   */
+  onComplete(listener: () => void): void {
+    if (this.isComplete) {
+      listener();
+      return;
+    }
+    this.completeListeners.push(listener);
+  }
+
+  /**
+   * Create a new stream replaying the body from the start
+   */
+  subscribe(): ReadableStream<Uint8Array> {
+    let cursor = 0;
+    let subscribed = true;
+    this.subscribers++;
+
+    const unsubscribe = () => {
+      if (!subscribed) return;
+      subscribed = false;
+      this.subscribers--;
+      if (this.subscribers === 0 && !this.isComplete) {
+        // Nobody is left to read the rest of the body
+        this.fail(new Error('Shared response body was cancelled'));
+        void this.reader?.cancel();
+      }
+    };
+
+    return new ReadableStream<Uint8Array>({
+      pull: async controller => {
+        while (cursor >= this.chunks.length && !this.isComplete) {
+          await this.readMore();
+        }
+        if (cursor < this.chunks.length) {
+          controller.enqueue(this.chunks[cursor++]);
+          return;
+        }
+        unsubscribe();
+        if (this.failed) {
+          controller.error(this.error);
+        } else {
+          controller.close();
+        }
+      },
+
+      cancel: unsubscribe,
+    });
+  }
+
+  private readMore(): Promise<void> {
+    if (this.reading === null) {
+      this.reading = this.reader!.read().then(
+        result => {
+          this.reading = null;
+          if (result.done) {
+            this.complete();
+          } else {
+            this.chunks.push(result.value);
+          }
+        },
+        (error: unknown) => {
+          this.reading = null;
+          this.fail(error);
+        }
+      );
+    }
+    return this.reading;
+  }
+
+  private fail(error: unknown): void {
+    if (this.isComplete) return;
+    this.failed = true;
+    this.error = error;
+    this.complete();
+  }
+
+  private complete(): void {
+    this.done = !this.failed;
+    const listeners = this.completeListeners;
+    this.completeListeners = [];
+    listeners.forEach(listener => listener());
+  }
+}
+
+/**
+ * Response whose status, headers and body are shared between every caller
+ * that made the same request
+ */
+export class SharedResponse {
+  readonly status: number;
+  readonly statusText: string;
+  readonly headers: KV[];
+  readonly body: SharedBody;
+
+  constructor(
+    status: number,
+    statusText: string,
+    headers: KV[],
+    body: SharedBody
+  ) {
+    this.status = status;
+    this.statusText = statusText;
+    this.headers = headers;
+    this.body = body;
+  }
+
+  /**
+   * Take ownership of a ConfsecResponse. Non-streaming responses are closed
+   * right away; streaming responses are closed once the body has been read.
+   */
+  static from(confsecResponse: ConfsecResponse): SharedResponse {
+    let body: SharedBody;
+    try {
+      body = confsecResponse.isStreaming
+        ? new SharedBody(confsecResponse.getStream().toReadableStream())
+        : new SharedBody(new Uint8Array(confsecResponse.body));
+      const metadata = confsecResponse.metadata;
+      if (!confsecResponse.isStreaming) {
+        confsecResponse.close();
+      }
+      const timings = formatTimings(confsecResponse.timings);
+      return new SharedResponse(
+        metadata.status_code,
+        metadata.reason_phrase,
+        [...metadata.headers, { key: TIMINGS_HEADER, value: timings }],
+        body
+      );
+    } catch (e) {
+      confsecResponse.close();
+      throw e;
+    }
+  }
+
+  /**
+   * Create a fetch Response reading from the shared body
+   */
+  toResponse(): Response {
+    const headers = new Headers();
+    this.headers.forEach(header => {
+      headers.append(header.key, header.value);
+    });
+    return new Response(this.body.subscribe(), {
+      status: this.status,
+      statusText: this.statusText,
+      headers,
+    });
+  }
+}
+
+/**
+ * Coalesces concurrent calls with the same key into a single call whose
+ * result is shared by every caller
+ */
+export class SingleFlight<T> {
+  private flights = new Map<string, Promise<T>>();
+  private _coalesced = 0;
+
+  /** Number of calls that attached to an existing flight */
+  get coalesced(): number {
+    return this._coalesced;
+  }
+
+  /** Number of flights currently registered */
+  get size(): number {
+    return this.flights.size;
+  }
+
+  /**
+   * Run fn, unless a call with the same key is already in flight, in which
+   * case attach to that call instead. A successful flight stays registered
+   * until forget is called; a failed flight is forgotten automatically.
+   */
+  do(key: string, fn: () => Promise<T>): Promise<T> {
+    const existing = this.flights.get(key);
+    if (existing !== undefined) {
+      this._coalesced++;
+      return existing;
+    }
+
+    const flight = fn();
+    this.flights.set(key, flight);
+    flight.catch(() => {
+      if (this.flights.get(key) === flight) {
+        this.flights.delete(key);
+      }
+    });
+    return flight;
+  }
+
+  /**
+   * Stop attaching new calls to the flight with the given key
+   */
+  forget(key: string): void {
+    this.flights.delete(key);
+  }
+}
@@ -0,0 +1,243 @@
+import { subscribe, unsubscribe } from 'diagnostics_channel';
+import {
+  DIAGNOSTICS_CHANNELS,
+  RequestChunkMessage,
+  RequestEndMessage,
+  RequestErrorMessage,
+  RequestStartMessage,
+} from './diagnostics';
+import { ResponseTimings } from './response';
+import { ILibconfsec, NativeTrace } from './types';
+
+/**
+ * Configuration for tracing
+ */
+export interface TracingConfig {
+  /**
+   * Number of native spans, and separately of fetch request events, kept in
+   * memory; the oldest are dropped once it is reached (default: 65536)
+   */
+  capacity?: number;
+}
+
+/**
+ * Event in the Chrome trace event format
+ */
+export interface TraceEvent {
+  name: string;
+  cat?: string;
+  ph: string;
+  /** Timestamp in microseconds */
+  ts: number;
+  pid: number;
+  tid: number;
+  /** Duration in microseconds of complete ('X') events */
+  dur?: number;
+  /** Id grouping asynchronous events */
+  id?: string;
+  args?: Record<string, unknown>;
+}
+
+/**
+ * Trace in the Chrome trace event format, which can be loaded in Perfetto or
+ * chrome://tracing once serialized to JSON
+ */
+export interface ChromeTrace {
+  traceEvents: TraceEvent[];
+  displayTimeUnit: 'ms';
+}
+
+// Events of fetch requests are attributed to the JS thread once its id is
+// known
+type RequestEvent = Omit<TraceEvent, 'pid' | 'tid'>;
+
+// Phases of a fetch request, between two of its timings
+const REQUEST_PHASES: [
+  string,
+  keyof ResponseTimings,
+  keyof ResponseTimings,
+][] = [
+  ['serialize', 'queued', 'serialized'],
+  ['wait for slot', 'serialized', 'submitted'],
+  ['wait for headers', 'submitted', 'headersReceived'],
+  ['read body', 'headersReceived', 'closed'],
+];
+
+/**
+ * Records the spans of native calls and worker threads, and the phases of
+ * fetch requests published on the diagnostics channels, into bounded buffers.
+ * Native spans cover every client in the process.
+ */
+export class Tracer {
+  private readonly libconfsec: ILibconfsec;
+  private readonly capacity: number;
+  private events: RequestEvent[] = [];
+  private dropped = 0;
+  private requestIds = new WeakMap<Request, string>();
+  private nextRequestId = 1;
+
+  private readonly onStart = (message: unknown) => {
+    const { request, timings } = message as RequestStartMessage;
+    const id = `request-${this.nextRequestId++}`;
+    this.requestIds.set(request, id);
+    this.push(
+      this.asyncEvent('b', request.url, id, timings.queued!, {
+        method: request.method,
+      })
+    );
+  };
+
+  private readonly onChunk = (message: unknown) => {
+    const { request, chunk } = message as RequestChunkMessage;
+    const id = this.requestIds.get(request);
+    if (id !== undefined) {
+      this.push(
+        this.asyncEvent('n', 'chunk', id, performance.now(), {
+          bytes: chunk.length,
+        })
+      );
+    }
+  };
+
+  private readonly onEnd = (message: unknown) => {
+    const { request, timings } = message as RequestEndMessage;
+    this.endRequest(request, timings);
+  };
+
+  private readonly onError = (message: unknown) => {
+    const { request, error, timings } = message as RequestErrorMessage;
+    const id = this.requestIds.get(request);
+    if (id === undefined) {
+      return;
+    }
+    this.push(
+      this.asyncEvent('n', 'error', id, performance.now(), {
+        error: String(error),
+      })
+    );
+    // Requests that failed before their response have no end message
+    if (timings.headersReceived === undefined) {
+      this.endRequest(request, timings);
+    }
+  };
+
+  constructor(libconfsec: ILibconfsec, { capacity = 65536 }: TracingConfig) {
+    if (!(capacity >= 1)) {
+      throw new Error('capacity must be at least 1');
+    }
+    this.libconfsec = libconfsec;
+    this.capacity = capacity;
+  }
+
+  start(): void {
+    this.libconfsec.confsecTraceStart(this.capacity);
+    subscribe(DIAGNOSTICS_CHANNELS.start, this.onStart);
+    subscribe(DIAGNOSTICS_CHANNELS.chunk, this.onChunk);
+    subscribe(DIAGNOSTICS_CHANNELS.end, this.onEnd);
+    subscribe(DIAGNOSTICS_CHANNELS.error, this.onError);
+  }
+
+  /**
+   * Stop recording, and return everything recorded as a Chrome trace
+   */
+  stop(): ChromeTrace {
+    unsubscribe(DIAGNOSTICS_CHANNELS.start, this.onStart);
+    unsubscribe(DIAGNOSTICS_CHANNELS.chunk, this.onChunk);
+    unsubscribe(DIAGNOSTICS_CHANNELS.end, this.onEnd);
+    unsubscribe(DIAGNOSTICS_CHANNELS.error, this.onError);
+    const native = this.libconfsec.confsecTraceStop();
+    return this.toChromeTrace(native, performance.now() * 1000);
+  }
+
+  private toChromeTrace(native: NativeTrace, nowUs: number): ChromeTrace {
+    const pid = process.pid;
+    // Native timestamps are rebased onto performance.now()
+    const offsetUs = nowUs - native.nowUs;
+    const threads = new Set<number>([native.tid]);
+    const traceEvents: TraceEvent[] = [];
+    native.spans.forEach(({ name, tid, startUs, endUs, id }) => {
+      threads.add(tid);
+      const ts = startUs + offsetUs;
+      if (id === 0) {
+        const dur = endUs - startUs;
+        traceEvents.push({ name, ph: 'X', ts, dur, pid, tid });
+      } else {
+        const base = { name, cat: 'native', id: `native-${id}`, pid, tid };
+        traceEvents.push({ ...base, ph: 'b', ts });
+        traceEvents.push({ ...base, ph: 'e', ts: endUs + offsetUs });
+      }
+    });
+    this.events.forEach(event => {
+      traceEvents.push({ ...event, pid, tid: native.tid });
+    });
+    threads.forEach(tid => {
+      traceEvents.push({
+        name: 'thread_name',
+        ph: 'M',
+        ts: 0,
+        pid,
+        tid,
+        args: { name: tid === native.tid ? 'JavaScript' : `worker ${tid}` },
+      });
+    });
+    if (this.dropped > 0) {
+      traceEvents.push({
+        name: 'dropped request events',
+        ph: 'i',
+        ts: nowUs,
+        pid,
+        tid: native.tid,
+        args: { count: this.dropped },
+      });
+    }
+    return { traceEvents, displayTimeUnit: 'ms' };
+  }
+
+  private endRequest(request: Request, timings: ResponseTimings): void {
+    const id = this.requestIds.get(request);
+    if (id === undefined) {
+      return;
+    }
+    this.requestIds.delete(request);
+    REQUEST_PHASES.forEach(([name, from, to]) => {
+      const start = timings[from];
+      const end = timings[to];
+      if (start !== undefined && end !== undefined) {
+        this.push(this.asyncEvent('b', name, id, start));
+        this.push(this.asyncEvent('e', name, id, end));
+      }
+    });
+    const end = timings.closed ?? performance.now();
+    this.push(this.asyncEvent('e', request.url, id, end));
+  }
+
+  private asyncEvent(
+    ph: string,
+    name: string,
+    id: string,
+    timeMs: number,
+    args?: Record<string, unknown>
+  ): RequestEvent {
+    const event: RequestEvent = {
+      name,
+      cat: 'request',
+      ph,
+      ts: timeMs * 1000,
+      id,
+    };
+    if (args !== undefined) {
+      event.args = args;
+    }
+    return event;
+  }
+
+  // Keep the last capacity events
+  private push(event: RequestEvent): void {
+    if (this.events.length < this.capacity) {
+      this.events.push(event);
+    } else {
+      this.events[this.dropped % this.capacity] = event;
+      this.dropped++;
+    }
+  }
+}
@@ -1,10 +1,122 @@
 // Type definitions for the native libconfsec module
 
+import type { ConfsecErrorCode } from './errors';
+
 export const enum IdentityPolicySource {
   CONFIGURED = 0,
   UNSAFE_REMOTE = 1,
 }
 
+/**
+ * Process-wide counters maintained by the native binding
+ */
+export interface NativeStats {
+  /** Clients created and not yet destroyed */
+  liveClients: number;
+  /**
+   * Requests waiting for libconfsec to return a response. Synchronous requests
+   * block the JS thread while they wait, so they are never seen here from
+   * that thread; this covers requests sent asynchronously, as hedged clients
+   * do, and synchronous requests of other worker threads.
+   */
+  inFlightRequests: number;
+  /** Responses returned and not yet destroyed */
+  liveResponses: number;
+  /** Response streams opened and not yet destroyed */
+  openStreams: number;
+  /** Request bytes held by the binding for inFlightRequests */
+  nativeBytesOutstanding: number;
+  /** Requests sent since the process started */
+  requests: number;
+  /** Stream chunks delivered since the process started */
+  chunks: number;
+  /** Body and chunk bytes delivered since the process started */
+  bytesDelivered: number;
+  /** Errors raised by libconfsec since the process started, by class */
+  errors: Record<ConfsecErrorCode, number>;
+}
+
+/**
+ * Chunk read from a response stream on the thread pool
+ */
+export interface StreamChunk {
+  /** The chunk, or null if there are no more chunks */
+  chunk: Buffer | null;
+  /** Time in ms from libconfsec returning the chunk to it reaching JS */
+  delayMs: number;
+}
+
+/**
+ * Wall time spent in one synchronous function of the binding, during which
+ * the JS thread is blocked
+ */
+export interface NativeCallStats {
+  /** Calls since the process started or the stats were reset */
+  calls: number;
+  /** Total time spent in the calls, in ms */
+  totalMs: number;
+  /** Longest call, in ms */
+  maxMs: number;
+  /**
+   * Number of calls by duration: buckets[0] counts calls under 1us, and
+   * buckets[i] calls of at least 2^(i-1)us and under 2^i us
+   */
+  buckets: number[];
+}
+
+/**
+ * Called with the name of a synchronous function of the binding and the time
+ * in ms it blocked the JS thread for
+ */
+export type SlowCallHook = (name: string, durationMs: number) => void;
+
+/**
+ * Handle created by the binding and not yet destroyed, recorded while handle
+ * tracking is enabled
+ */
+export interface LiveHandle {
+  kind: 'client' | 'response' | 'stream';
+  handle: number;
+  /** Time in ms since the handle was created */
+  ageMs: number;
+  /** JS stack of the call that created the handle */
+  stack: string;
+}
+
+/**
+ * Span of native work recorded while tracing. Timestamps are in microseconds
+ * of a monotonic clock.
+ */
+export interface NativeSpan {
+  /** Binding function or libconfsec call the span covers */
+  name: string;
+  /** Small sequential id of the thread the span was recorded on */
+  tid: number;
+  startUs: number;
+  endUs: number;
+  /** Id shared by the spans of one asynchronous operation, or 0 */
+  id: number;
+}
+
+/**
+ * Spans recorded by the binding between confsecTraceStart and
+ * confsecTraceStop
+ */
+export interface NativeTrace {
+  /** Time at which the trace was stopped, on the clock of the spans */
+  nowUs: number;
+  /** Thread id of the JS thread */
+  tid: number;
+  spans: NativeSpan[];
+}
+
+/**
+ * Node tags held by the binding, opaque to JS
+ */
+export interface NativeNodeTagSet {
+  readonly __nativeNodeTagSet: never;
+}
+
 export interface ILibconfsec {
   /**
    * Create a new CONFSEC client
@@ -65,13 +177,22 @@ export interface ILibconfsec {
   /**
    * Set the default node tags for a client
    * @param handle - Handle to the client
-   * @param defaultNodeTags - Array of node tags to set
+   * @param defaultNodeTags - Array of node tags to set, or a node tag set
    */
   confsecClientSetDefaultNodeTags(
     handle: number,
-    defaultNodeTags: string[]
+    defaultNodeTags: string[] | NativeNodeTagSet
   ): void;
 
+  /**
+   * Marshal node tags once, for use with any client and request of the
+   * binding. The tags are freed once the returned object is garbage
+   * collected.
+   * @param tags - Node tags, which must not contain commas or line breaks
+   * @returns Opaque handle to the tags
+   */
+  confsecNodeTagSetCreate(tags: string[]): NativeNodeTagSet;
+
   /**
    * Get the wallet status for a client
    * @param handle - Handle to the client
@@ -79,13 +200,71 @@ export interface ILibconfsec {
    */
   confsecClientGetWalletStatus(handle: number): string;
 
+  /**
+   * Start refreshing the wallet status of a client on a background thread,
+   * right away and then at an interval, replacing any refresh already running
+   * for it
+   * @param handle - Handle to the client
+   * @param intervalMs - Interval between refreshes
+   */
+  confsecClientStartWalletRefresh(handle: number, intervalMs: number): void;
+
+  /**
+   * Copy the last wallet status refreshed in the background into status,
+   * without calling into libconfsec
+   * @param handle - Handle to the client
+   * @param status - Receives the credits available, held and spent
+   * @returns Whether a status was copied: false if no refresh is running for
+   * the client or none has succeeded yet
+   */
+  confsecClientReadWallet(handle: number, status: Float64Array): boolean;
+
+  /**
+   * Refresh the wallet status of a client in the background as soon as
+   * possible, if a refresh was started for it
+   * @param handle - Handle to the client
+   */
+  confsecClientRefreshWallet(handle: number): void;
+
+  /**
+   * Stop refreshing the wallet status of a client, without waiting for a
+   * refresh in flight. Destroying the client also stops it, but waits.
+   * @param handle - Handle to the client
+   * @returns Promise resolving once the client is no longer used by the
+   * refresh thread
+   */
+  confsecClientStopWalletRefresh(handle: number): Promise<void>;
+
   /**
    * Send a request through the CONFSEC network
    * @param handle - Handle to the client
    * @param request - The HTTP request as string or buffer
+   * @param nodeTags - Tags added to the request's x-confsec-node-tags header,
+   * on top of the client's default tags, as an array or node tag set. Throws
+   * a TypeError if the request has no terminated request line to add them to.
    * @returns Handle to the response
    */
-  confsecClientDoRequest(handle: number, request: string | Buffer): number;
+  confsecClientDoRequest(
+    handle: number,
+    request: string | Buffer,
+    nodeTags?: string[] | NativeNodeTagSet
+  ): number;
+
+  /**
+   * Send a request through the CONFSEC network without blocking the event
+   * loop. The request runs on the libuv thread pool.
+   * @param handle - Handle to the client
+   * @param request - The HTTP request as string or buffer
+   * @param nodeTags - Tags added to the request's x-confsec-node-tags header,
+   * on top of the client's default tags, as an array or node tag set. Throws
+   * a TypeError if the request has no terminated request line to add them to.
+   * @returns Promise resolving to the handle of the response
+   */
+  confsecClientDoRequestAsync(
+    handle: number,
+    request: string | Buffer,
+    nodeTags?: string[] | NativeNodeTagSet
+  ): Promise<number>;
 
   /**
    * Destroy a response object
@@ -128,9 +307,73 @@ export interface ILibconfsec {
    */
   confsecResponseStreamGetNext(handle: number): Buffer | null;
 
+  /**
+   * Get the next chunk from a response stream, on the thread pool
+   * @param handle - Handle to the stream
+   * @returns Promise of the chunk and the time it waited for the JS thread
+   */
+  confsecResponseStreamGetNextAsync(handle: number): Promise<StreamChunk>;
+
   /**
    * Destroy a response stream
    * @param handle - Handle to the stream
    */
   confsecResponseStreamDestroy(handle: number): void;
+
+  /**
+   * Get the process-wide counters maintained by the binding. Counters are
+   * read without locking, so they may not be mutually consistent.
+   * @returns Snapshot of the counters
+   */
+  confsecGetStats(): NativeStats;
+
+  /**
+   * Get the wall time spent in each synchronous function of the binding,
+   * across the process
+   * @returns Stats keyed by function name
+   */
+  confsecGetCallStats(): Record<string, NativeCallStats>;
+
+  /**
+   * Reset the stats returned by confsecGetCallStats
+   */
+  confsecResetCallStats(): void;
+
+  /**
+   * Set the hook called on the next turn of the event loop after a
+   * synchronous call takes at least thresholdMs, replacing any previous hook.
+   * The hook must not throw.
+   * @param thresholdMs - Duration from which calls are reported, in ms
+   * @param hook - Hook to call, or null to remove the hook
+   */
+  confsecSetSlowCallHook(thresholdMs: number, hook: SlowCallHook | null): void;
+
+  /**
+   * Start recording spans of native work across the process, in a ring
+   * buffer keeping the last capacity spans. Throws if tracing was already
+   * started.
+   * @param capacity - Number of spans kept
+   */
+  confsecTraceStart(capacity: number): void;
+
+  /**
+   * Stop recording spans of native work
+   * @returns The spans recorded since tracing started
+   */
+  confsecTraceStop(): NativeTrace;
+
+  /**
+   * Enable or disable recording the handles created across the process.
+   * Calls are counted: handles are recorded until every call enabling
+   * tracking has been matched by one disabling it, at which point the
+   * records are dropped.
+   * @param enabled - Whether to enable or disable tracking
+   */
+  confsecTrackHandles(enabled: boolean): void;
+
+  /**
+   * Get the handles created while tracking was enabled and not yet destroyed
+   * @returns The live handles
+   */
+  confsecGetLiveHandles(): LiveHandle[];
 }